@@ -36,6 +36,9 @@ public:
     // Request to exit app (handled by main loop)
     bool wantsToExit = false;
 
+    // Skip the main loop's idle delay, e.g. while benchmarking
+    bool wantsFullSpeed = false;
+
     // Request keyboard input
     bool needsKeyboard = false;
     char keyboardBuffer[64] = {0};
@@ -15,8 +15,11 @@ public:
 private:
     bool loading = false;
     bool hasData = false;
+    bool stale = false;            // Showing cached prices from flash
     char errorMsg[32] = "";
     unsigned long lastFetch = 0;
+    unsigned long lastAttempt = 0;
+    uint32_t cachedAt = 0;
 
     float btcPrice = 0;
     float ethPrice = 0;
@@ -26,6 +29,8 @@ private:
     float solChange = 0;
 
     void fetchPrices();
+    void loadCached();
+    void saveCached();
 };
 
 #endif
@@ -2,6 +2,11 @@
 #define FACTS_H
 
 #include "app.h"
+#include "prefetch_queue.h"
+
+struct FactItem {
+    char text[256];
+};
 
 class FactsApp : public App {
 public:
@@ -17,8 +22,12 @@ private:
     bool hasData = false;
     char errorMsg[32] = "";
     char fact[256] = "";
+    bool stale = false;            // Showing the last fact saved to flash
+
+    PrefetchQueue<FactItem, PREFETCH_DEPTH> queue{fillQueue};
 
     void fetchFact();
+    static int fillQueue(PrefetchQueue<FactItem, PREFETCH_DEPTH>& q, int wanted);
 };
 
 #endif
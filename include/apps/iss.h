@@ -15,8 +15,11 @@ public:
 private:
     bool loading = false;
     bool hasData = false;
+    bool stale = false;            // Showing cached position from flash
     char errorMsg[32] = "";
     unsigned long lastFetch = 0;
+    unsigned long lastAttempt = 0;
+    uint32_t cachedAt = 0;
 
     float latitude = 0;
     float longitude = 0;
@@ -25,6 +28,8 @@ private:
 
     void fetchISS();
     void fetchAstronauts();
+    void loadCached();
+    void saveCached();
 };
 
 #endif
@@ -2,6 +2,13 @@
 #define JOKES_H
 
 #include "app.h"
+#include "prefetch_queue.h"
+
+struct JokeItem {
+    char setup[128];
+    char delivery[128];
+    bool single;
+};
 
 class JokesApp : public App {
 public:
@@ -20,8 +27,12 @@ private:
     char setup[128] = "";
     char delivery[128] = "";
     bool isSingleJoke = false;
+    bool stale = false;            // Showing the last joke saved to flash
+
+    PrefetchQueue<JokeItem, PREFETCH_DEPTH> queue{fillQueue};
 
     void fetchJoke();
+    static int fillQueue(PrefetchQueue<JokeItem, PREFETCH_DEPTH>& q, int wanted);
 };
 
 #endif
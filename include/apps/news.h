@@ -17,8 +17,10 @@ public:
 private:
     bool loading = false;
     bool hasData = false;
+    bool stale = false;            // Showing cached headlines from flash
     char errorMsg[32] = "";
     unsigned long lastFetch = 0;
+    unsigned long lastAttempt = 0;
 
     char headlines[MAX_HEADLINES][80];
     char sources[MAX_HEADLINES][24];
@@ -26,6 +28,8 @@ private:
     int currentIndex = 0;
 
     void fetchNews();
+    void loadCached();
+    void saveCached();
 };
 
 #endif
@@ -2,7 +2,7 @@
 #define OTA_H
 
 #include "app.h"
-#include <WebServer.h>
+#include <ESPAsyncWebServer.h>
 
 class OTAApp : public App {
 public:
@@ -14,6 +14,9 @@ public:
     const char* getName() override { return "OTA Update"; }
     const uint8_t* getIcon() override;
 
+    // Adds /ota and /update to the shared web server; called once at boot
+    static void registerRoutes();
+
     // Called by upload handler
     static void setProgress(int percent);
     static void setError(const char* msg);
@@ -28,18 +31,15 @@ private:
         ERROR
     };
 
-    static State state;
-    static int uploadProgress;
+    // Written from the web server task
+    static volatile State state;
+    static volatile int uploadProgress;
     static char errorMsg[48];
-    
-    WebServer* server;
-    
-    void startServer();
-    void stopServer();
-    
-    static void handleRoot();
-    static void handleUpdate();
-    static void handleUpload();
+    static volatile bool armed;     // Uploads are accepted only while the app is open
+
+    static void handleUpdate(AsyncWebServerRequest* request);
+    static void handleUpload(AsyncWebServerRequest* request, const String& filename,
+                             size_t index, uint8_t* data, size_t len, bool final);
 };
 
 #endif
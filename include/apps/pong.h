@@ -2,7 +2,7 @@
 #define PONG_H
 
 #include "app.h"
-#include <WebSocketsServer.h>
+#include <ESPAsyncWebServer.h>
 
 class PongApp : public App {
 public:
@@ -14,6 +14,10 @@ public:
     const char* getName() override { return "Pong"; }
     const uint8_t* getIcon() override;
 
+    // Adds /pong and the /pong/ws socket to the shared web server;
+    // called once at boot
+    static void registerRoutes();
+
 private:
     enum class State {
         MENU,
@@ -43,39 +47,81 @@ private:
     // AI/Player2 paddle (right)
     int aiY = 26;
     int aiScore = 0;
-    float aiSpeed = 1.5;
+    int32_t aiSpeed = 384;          // Fixed point, px per tick
+    int32_t aiCarry = 0;            // Sub-pixel AI movement not applied yet
 
-    // Ball
-    float ballX = 64;
-    float ballY = 32;
-    float ballVX = 2;
-    float ballVY = 1;
+    // Ball, fixed point (see FP_SHIFT in pong.cpp): position in 1/256 px,
+    // velocity in 1/256 px per tick
+    int32_t ballX = 64 << 8;
+    int32_t ballY = 32 << 8;
+    int32_t ballVX = 2 << 8;
+    int32_t ballVY = 1 << 8;
 
     // Game settings
     int winScore = 5;
-    unsigned long lastUpdate = 0;
     bool playerWon = false;
 
+    // Fixed timestep: update() runs as many physics ticks as real time
+    // allows, so game speed doesn't depend on render or network load
+    unsigned long lastTickAt = 0;   // micros()
+    uint32_t tickBacklog = 0;       // us not yet simulated
+    uint32_t rng = 1;               // Serve angles; seeded per game
+
     // Mode selection
     int modeSelectIndex = 0;
 
     // WebSocket for PvP
-    WebSocketsServer* wsServer = nullptr;
     bool player2Connected = false;
-    int player2ClientNum = -1;
+    uint32_t player2ClientId = 0;   // AsyncWebSocket ids start at 1
     unsigned long lastP2Update = 0;
     bool player2Ready = false;
+    uint8_t p2Held = 0;             // Buttons P2 holds down (HOLD_UP/HOLD_DOWN)
+    uint8_t p2InputSeq = 0;         // Last input applied, echoed in frames
+    uint32_t p2RttMs = 0;           // Smoothed ping round trip, 0 = not measured yet
+    unsigned long lastPing = 0;
+
+    // Binary state frames (see encodeFrame): fields as last sent, so
+    // unchanged ones can be left out
+    struct SentFields {
+        uint8_t p1;
+        uint8_t p2;
+        uint16_t ballX;     // 1/16 px
+        uint16_t ballY;
+        uint8_t score;      // p1 << 4 | p2
+        uint8_t state;      // 0 waiting, 1 playing, 2 game over
+        uint8_t ack;        // P2 input sequence, low 6 bits
+    };
+    SentFields lastSent = {};
+    uint8_t frameSeq = 0;
+    uint8_t framesSinceKey = 0;
+    bool p2NeedsKey = true;
+
+    // Read-only sockets beyond P2; they get the same frames
+    static const int MAX_SPECTATORS = 4;
+    struct Spectator {
+        uint32_t clientId;
+        bool needsKey;      // Just joined or missed a frame
+    };
+    Spectator spectators[MAX_SPECTATORS] = {};
+    int spectatorCount = 0;
 
     void startGame();
     void resetBall(bool towardsPlayer);
     void updateAI();
+    uint8_t stepPhysics(uint8_t p1Held);
+    int32_t crossingY(int32_t faceX, int32_t x0, int32_t y0);
 
     // WebSocket methods
     void startWebSocketServer();
     void stopWebSocketServer();
     void sendGameState();
-    void onWebSocketEvent(uint8_t num, WStype_t type, uint8_t* payload, size_t length);
-    static void wsEventHandler(uint8_t num, WStype_t type, uint8_t* payload, size_t length);
+    SentFields snapshot();
+    size_t encodeFrame(uint8_t* out, const SentFields& now, bool keyframe, uint16_t stamp);
+    void pollNetEvents();
+    void onWebSocketEvent(uint32_t clientId, AwsEventType type, char cmd,
+                          uint8_t seq, uint8_t held);
+    static void wsEventHandler(AsyncWebSocket* server, AsyncWebSocketClient* client,
+                               AwsEventType type, void* arg, uint8_t* data, size_t len);
 };
 
 #endif
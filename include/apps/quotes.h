@@ -2,6 +2,12 @@
 #define QUOTES_H
 
 #include "app.h"
+#include "prefetch_queue.h"
+
+struct QuoteItem {
+    char quote[200];
+    char author[48];
+};
 
 class QuotesApp : public App {
 public:
@@ -18,8 +24,12 @@ private:
     char errorMsg[32] = "";
     char quote[200] = "";
     char author[48] = "";
+    bool stale = false;            // Showing the last quote saved to flash
+
+    PrefetchQueue<QuoteItem, PREFETCH_DEPTH> queue{fillQueue};
 
     void fetchQuote();
+    static int fillQueue(PrefetchQueue<QuoteItem, PREFETCH_DEPTH>& q, int wanted);
 };
 
 #endif
@@ -2,6 +2,7 @@
 #define SETTINGS_H
 
 #include "app.h"
+#include "wifi_manager.h"
 
 class SettingsApp : public App {
 public:
@@ -18,6 +19,7 @@ private:
         WIFI_LIST,
         WIFI_SCAN,
         WIFI_PASSWORD,
+        WIFI_CONNECTING,
         API_KEYS,
         EDIT_API_KEY,
         BRIGHTNESS,
@@ -28,7 +30,10 @@ private:
     Mode mode = Mode::MENU;
     int menuIndex = 0;
     int wifiIndex = 0;
-    bool scanning = false;
+    char wifiHighlight[33] = {0};  // SSID under the cursor, kept across re-sorts
+    uint32_t wifiScanVersion = 0;
+    ConnectPhase lastConnectPhase = ConnectPhase::NONE;  // Last in-progress phase seen
+    bool connectFinished = false;
 
     char weatherApiKey[48] = {0};
     char newsApiKey[48] = {0};
@@ -45,6 +50,9 @@ private:
     void saveSettings();
     void renderMenu();
     void renderWifiList();
+    void trackWifiSelection();
+    void startConnect(const char* password);
+    void renderConnecting();
     void renderApiKeys();
     void renderBrightness();
     void renderSleepTimeout();
@@ -2,10 +2,11 @@
 #define SNAKE_H
 
 #include "app.h"
+#include "apps/snake_game.h"
 
-#define SNAKE_GRID_W 32
-#define SNAKE_GRID_H 16
-#define SNAKE_MAX_LEN 64
+#define SNAKE_REPLAY_MAX_TURNS 1024 // 6 bits each; longer runs aren't kept
+#define SNAKE_PLAYBACK_SPEEDUP 4    // Watch best run at this multiple
+#define SNAKE_AUTOPLAY_FRAME_US 50000   // Autoplay redraws this often; moves fill the rest
 
 class SnakeApp : public App {
 public:
@@ -20,37 +21,78 @@ private:
     enum class State {
         MENU,
         PLAYING,
+        REPLAY,
+        AUTOPLAY,
         GAME_OVER
     };
 
+    // A run as its seed and turns. Each turn is 6 bits: steps since the
+    // previous turn minus one (a straight line is at most 32 steps) and
+    // the side, 1 = clockwise. Stored in NVS for the high score run.
+    struct Replay {
+        uint32_t seed;
+        uint16_t moves;         // Steps in the run; playback stops there
+        uint16_t turns;
+        uint16_t lastTurnAt;
+        bool complete;          // False if the run didn't fit
+        uint8_t bits[(SNAKE_REPLAY_MAX_TURNS * 6 + 7) / 8];
+
+        void start(uint32_t seed);
+        void record(uint16_t move, bool clockwise);
+    };
+
+    // Position in a Replay while playing it back
+    struct ReplayCursor {
+        int turn;
+        uint16_t nextTurnAt;
+    };
+
     State state = State::MENU;
+    SnakeGame game;
+    Replay run;             // Being recorded
+    Replay best;            // High score run, if one was saved
+    bool hasBest = false;
 
-    // Snake body (circular buffer)
-    int8_t snakeX[SNAKE_MAX_LEN];
-    int8_t snakeY[SNAKE_MAX_LEN];
-    int snakeLen = 3;
-    int snakeHead = 0;
+    // Race against the best run, re-simulated step for step
+    bool racingGhost = false;
+    SnakeGame ghost;
+    ReplayCursor ghostCursor;
+    ReplayCursor playbackCursor;
 
-    // Direction: 0=right, 1=down, 2=left, 3=up
-    int direction = 0;
-    int nextDirection = 0;
+    // Autoplay: a solver plays flat out until the board is full, as a
+    // repeatable load on game logic and rendering. Totals for the report.
+    bool autoplay = false;
+    struct AutoplayStats {
+        unsigned long startedAt;    // millis()
+        unsigned long elapsedMs;
+        uint32_t moves;
+        uint32_t frames;
+        uint32_t planUs;            // Solver
+        uint32_t stepUs;            // SnakeGame::step
+        uint32_t drawUs;            // Drawing into the buffer
+        uint32_t flushUs;           // Sending the buffer to the display
+    };
+    AutoplayStats stats;
+    unsigned long frameDueAt = 0;   // micros(), for the next autoplay frame
 
-    // Food
-    int8_t foodX = 0;
-    int8_t foodY = 0;
+    int nextDirection = 0;
+    int menuIndex = 0;
 
     // Game state
-    int score = 0;
     int highScore = 0;
     unsigned long lastMove = 0;
-    int speed = 150;  // ms per move
 
-    void startGame();
-    void moveSnake();
-    void spawnFood();
-    bool checkCollision(int x, int y);
+    void startGame(bool withGhost);
+    void startPlayback();
+    void startAutoplay();
+    void finishAutoplay();
+    void endGame();
+    int stepInterval();
+    void rewind(ReplayCursor& cursor);
+    int replayDirection(const SnakeGame& g, ReplayCursor& cursor);
     void loadHighScore();
     void saveHighScore();
+    void drawGame(const SnakeGame& g, bool asGhost);
 };
 
 #endif
@@ -0,0 +1,56 @@
+#ifndef SNAKE_GAME_H
+#define SNAKE_GAME_H
+
+#include <stdint.h>
+
+#define SNAKE_GRID_W 32
+#define SNAKE_GRID_H 16
+#define SNAKE_CELLS (SNAKE_GRID_W * SNAKE_GRID_H)
+#define SNAKE_MAX_LEN SNAKE_CELLS   // The snake can fill the board
+
+// One Snake board and the autoplay solver. Nothing here touches Arduino,
+// so it also builds on the host (pio test -e native).
+//
+// Food comes from the game's own PRNG and the snake moves in whole
+// steps, so a seed plus the turns taken replays a game exactly.
+struct SnakeGame {
+    // step() results
+    static const uint8_t STEP_ATE = 0x01;
+    static const uint8_t STEP_DIED = 0x02;
+    static const uint8_t STEP_FULL = 0x04;
+
+    // Snake body (circular buffer)
+    int8_t snakeX[SNAKE_MAX_LEN];
+    int8_t snakeY[SNAKE_MAX_LEN];
+    int snakeLen;
+    int snakeHead;
+
+    // One bit per cell (y * SNAKE_GRID_W + x), set where the body is.
+    // Kept in step with the head and tail, so collision is one lookup.
+    uint32_t occupied[SNAKE_CELLS / 32];
+
+    // Direction: 0=right, 1=down, 2=left, 3=up
+    int direction;
+
+    int8_t foodX;
+    int8_t foodY;
+    int score;
+    uint16_t moves;
+    uint32_t rng;
+    bool alive;
+    bool boardFull;
+
+    void reset(uint32_t seed);
+    uint8_t step(int newDirection);     // STEP_* flags
+    // Autoplay: the solver's direction for the next step
+    int planMove() const;
+    bool isOccupied(int x, int y) const;
+
+private:
+    uint32_t nextRandom(uint32_t n);
+    bool spawnFood();
+    bool checkCollision(int x, int y) const;
+    void setOccupied(int x, int y, bool on);
+};
+
+#endif
@@ -15,12 +15,15 @@ public:
 private:
     enum class Page {
         INFO,
+        NETWORK,
         BUTTON_TEST
     };
 
     Page currentPage = Page::INFO;
+    int hostScroll = 0;
 
     void renderInfo();
+    void renderNetwork();
     void renderButtonTest();
 };
 
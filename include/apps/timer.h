@@ -2,6 +2,9 @@
 #define TIMER_H
 
 #include "app.h"
+#include <esp_timer.h>
+
+#define TIMER_MAX_LAPS 16           // Stopwatch splits kept, oldest overwritten
 
 class TimerApp : public App {
 public:
@@ -16,15 +19,36 @@ private:
     enum class Mode { SELECT, COUNTDOWN_SETUP, COUNTDOWN, STOPWATCH };
     enum class State { STOPPED, RUNNING, PAUSED, FINISHED };
 
+    // Time in microseconds from esp_timer_get_time(), so both timers keep
+    // counting while other apps are open and don't depend on the loop rate
+    struct Span {
+        int64_t startedAt;      // While running
+        int64_t accumulated;    // Before the last pause
+        bool running;
+
+        void start();
+        void pause();
+        void reset();
+        int64_t elapsed() const;
+    };
+
     Mode mode = Mode::SELECT;
-    State state = State::STOPPED;
     int selectIndex = 0;  // 0=Countdown, 1=Stopwatch
 
-    // Timer values (in milliseconds)
-    unsigned long targetTime = 0;      // Countdown target
-    unsigned long elapsedTime = 0;     // Elapsed time
-    unsigned long startMillis = 0;     // When timer started
-    unsigned long pausedTime = 0;      // Time accumulated before pause
+    // Countdown. The alarm is an esp_timer one-shot armed for the exact
+    // end, so it sounds on time whatever the loop is doing.
+    State countdownState = State::STOPPED;
+    Span countdown = {};
+    int64_t targetUs = 0;
+    esp_timer_handle_t alarmTimer = nullptr;
+    volatile bool alarmFired = false;
+
+    // Stopwatch
+    State stopwatchState = State::STOPPED;
+    Span stopwatch = {};
+    int64_t laps[TIMER_MAX_LAPS];   // Elapsed time at each lap, ring buffer
+    int lapCount = 0;               // Laps taken, may exceed TIMER_MAX_LAPS
+    int lapView = 0;                // Laps back from the latest on screen
 
     // Countdown setup
     int setHours = 0;
@@ -37,7 +61,19 @@ private:
     void renderCountdown();
     void renderStopwatch();
     void formatTime(unsigned long ms, char* buf, bool showHours = true);
-    void playAlarm();
+    void formatSplit(int64_t us, char* buf);
+
+    void startCountdown();
+    void pauseCountdown();
+    void resumeCountdown();
+    void resetCountdown();
+    void armAlarm();
+    void checkAlarm();
+    static void onAlarm(void* arg);
+
+    void resetStopwatch();
+    void recordLap();
+    int64_t lapAt(int n);           // Elapsed time at lap n, 0 before the first
 };
 
 #endif
@@ -2,6 +2,13 @@
 #define TRIVIA_H
 
 #include "app.h"
+#include "prefetch_queue.h"
+
+struct TriviaItem {
+    char question[200];
+    char answers[4][64];
+    int correct;
+};
 
 class TriviaApp : public App {
 public:
@@ -31,8 +38,11 @@ private:
     int questionNum = 0;
     bool answered = false;
 
+    PrefetchQueue<TriviaItem, PREFETCH_DEPTH> queue{fillQueue};
+
     void fetchQuestion();
-    void decodeHtml(char* str);
+    static int fillQueue(PrefetchQueue<TriviaItem, PREFETCH_DEPTH>& q, int wanted);
+    static void decodeHtml(char* str);
 };
 
 #endif
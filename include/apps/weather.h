@@ -22,9 +22,13 @@ private:
     int humidity = 0;
     char description[32] = "";
     char errorMsg[32] = "";
+    bool stale = false;            // Showing cached conditions from flash
     unsigned long lastFetch = 0;
+    unsigned long lastAttempt = 0;
 
     void fetchWeather();
+    void loadCached();
+    void saveCached();
     void loadCity();
     void saveCity();
 };
@@ -0,0 +1,66 @@
+#ifndef AUDIO_H
+#define AUDIO_H
+
+#include <Arduino.h>
+#include <esp_timer.h>
+
+#define AUDIO_LEDC_CHANNEL 0
+#define AUDIO_QUEUE_SIZE 4          // Melodies waiting behind a more important sound
+
+// Priorities: a sound interrupts anything of the same or lower priority
+#define AUDIO_PRIO_EFFECT 0         // Game sounds
+#define AUDIO_PRIO_UI 1             // Key clicks, confirmations
+#define AUDIO_PRIO_MUSIC 2          // Jingles and melodies
+#define AUDIO_PRIO_ALARM 3          // Timer alarm
+
+// Buzzer output without delay(). Each note edge is an esp_timer one-shot
+// (hardware timer, callback on the esp_timer task) that retunes an LEDC
+// channel, so callers only queue a request under a spinlock.
+//
+// A preempted melody is queued and resumes where it was cut. A single
+// tone that can't play right away is dropped: a late sound effect is
+// worse than none.
+class Audio {
+public:
+    static void init();
+
+    static void tone(uint16_t freq, uint16_t ms, uint8_t priority = AUDIO_PRIO_UI);
+    // RTTTL, e.g. "name:d=4,o=5,b=120:8c6,p,g"; the string must outlive playback
+    static void play(const char* rtttl, uint8_t priority = AUDIO_PRIO_MUSIC);
+    static void stop();             // Current sound and everything queued
+
+    static bool isPlaying();
+    static uint32_t getDroppedCount();
+
+private:
+    struct Sound {
+        const char* rtttl;      // nullptr for a single tone
+        uint16_t pos;           // Next note in rtttl
+        uint16_t freq;          // Single tone; cleared once played
+        uint16_t ms;
+        uint16_t gapMs;         // Silence owed after the last note
+        uint16_t wholeMs;       // Whole note at the melody's tempo
+        uint8_t defDuration;
+        uint8_t defOctave;
+        uint8_t priority;
+    };
+
+    static esp_timer_handle_t timer;
+    static portMUX_TYPE mux;
+    static bool armed;              // Timer armed or its callback running
+    static uint32_t epoch;          // Bumped when the current sound is replaced
+    static Sound current;
+    static bool playing;
+    static Sound queue[AUDIO_QUEUE_SIZE];   // Highest priority first
+    static int queued;
+    static volatile uint32_t dropped;
+
+    static void submit(Sound& s);
+    static void preempt(bool wasIdle);
+    static bool enqueue(const Sound& s);
+    static void parseHeader(Sound& s);
+    static bool nextNote(Sound& s, uint16_t& freq, uint16_t& ms);
+    static void onTimer(void* arg);
+};
+
+#endif
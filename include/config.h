@@ -38,6 +38,7 @@
 #define BUZZER_PIN 15
 #define BEEP_FREQ 2000
 #define BEEP_DURATION 50
+#define BOOT_JINGLE "boot:d=16,o=6,b=300:b5,p,f#"     // RTTTL
 
 // NVS Namespace
 #define NVS_NAMESPACE "esp_os"
@@ -47,6 +48,22 @@
 #define NEWS_API_KEY "a7fb3c78c9e94f49945b1a74b49d2186"
 #define DEFAULT_CITY "Kollam"
 
+// Feed prefetch (Jokes, Facts, Quotes, Trivia)
+#define PREFETCH_DEPTH 5           // Parsed items kept ready per feed
+#define PREFETCH_LOW_WATER 2       // Refill when this many or fewer remain
+#define PREFETCH_SETTLE_MS 300     // Let a popped item render before refilling
+#define PREFETCH_RETRY_MS 15000    // Wait after a failed refill
+
+// HTTP record/replay fixtures (see http_fixtures.h)
+#define HTTP_FIXTURE_OFF 0
+#define HTTP_FIXTURE_RECORD 1          // Save httpGet 200 responses with a body to /fx
+#define HTTP_FIXTURE_REPLAY 2          // Serve httpGet from /fx (or the stand-in server)
+#define HTTP_FIXTURE_MODE HTTP_FIXTURE_OFF
+#define HTTP_FIXTURE_LATENCY_MS 0      // Added to every replayed request
+#define HTTP_FIXTURE_FAIL_PCT 0        // Share of replayed requests that time out
+#define HTTP_FIXTURE_SEED 12345        // Failure pattern seed (same seed, same pattern)
+#define HTTP_FIXTURE_BASE_URL ""       // e.g. "http://192.168.1.50:8000": replay from a local server
+
 // App count
 #define NUM_APPS 13
 
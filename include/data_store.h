@@ -0,0 +1,35 @@
+#ifndef DATA_STORE_H
+#define DATA_STORE_H
+
+#include <Arduino.h>
+
+// Last-known-good records on LittleFS. Each key holds one fixed-size
+// struct behind a small header (magic, length, CRC, save time), so apps
+// can show their previous result immediately after boot or wake.
+class DataStore {
+public:
+    // Mount LittleFS (formats the partition on first boot)
+    static bool init();
+    static bool isMounted();
+
+    // Persist a record; stamped with wall-clock time once NTP has synced
+    static bool save(const char* key, const void* data, uint16_t len);
+
+    // Load a record; false if missing, wrong size or corrupt.
+    // savedAt is 0 when the record was written before time sync.
+    static bool load(const char* key, void* data, uint16_t len, uint32_t* savedAt = nullptr);
+
+    static void remove(const char* key);
+
+    // "5m ago" style age of a saved record ("cached" if unknown)
+    static void formatAge(uint32_t savedAt, char* buf, size_t len);
+
+private:
+    static bool mounted;
+
+    static void makePath(const char* key, char* path, size_t len, bool temp);
+    static bool readRecord(const char* path, void* data, uint16_t len, uint32_t* savedAt);
+    static uint16_t crc16(const uint8_t* data, uint16_t len);
+};
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef HTTP_FIXTURES_H
+#define HTTP_FIXTURES_H
+
+#include <Arduino.h>
+
+// Record/replay of WiFiManager::httpGet traffic, selected by
+// HTTP_FIXTURE_MODE in config.h. Responses are recorded to LittleFS as
+// /fx/<url hash>.txt ("<status>\n<url>\n<body>"). Replay serves them
+// without touching the network - or forwards to a stand-in server when
+// HTTP_FIXTURE_BASE_URL is set - with optional added latency and
+// injected failures, so the network apps' parse and render paths can be
+// exercised and timed deterministically.
+class HttpFixtures {
+public:
+    static void init();
+    static bool isRecording();
+    static bool isReplaying();
+
+    // Replay mode: answer `url` from disk. Returns false when the request
+    // should go to the stand-in server instead (after any injected latency).
+    static bool replay(const char* url, String& payload, int& status);
+
+    // Record mode: store one response. Only non-empty 200s are kept, so a
+    // transient failure never replaces a good fixture.
+    static void record(const char* url, int status, const String& payload);
+
+    // Stand-in server: "https://api.x.com/p?q" -> "<base>/api.x.com/p?q".
+    // False (url untouched) when no base URL is configured.
+    static bool rewriteUrl(const char* url, char* out, size_t len);
+
+    static uint32_t getRecordedCount();
+    static uint32_t getReplayedCount();
+    static uint32_t getMissingCount();
+    static uint32_t getInjectedFailures();
+
+private:
+    static uint32_t recorded;
+    static uint32_t replayed;
+    static uint32_t missing;
+    static uint32_t injected;
+    static uint32_t rngState;
+
+    static void makePath(const char* url, char* path, size_t len, bool temp);
+    static uint32_t nextRandom();
+};
+
+#endif
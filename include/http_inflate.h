@@ -0,0 +1,44 @@
+#ifndef HTTP_INFLATE_H
+#define HTTP_INFLATE_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+#define HTTP_INFLATE_IN_CHUNK 512          // Input read buffer
+#define HTTP_INFLATE_MAX_OUT 65536         // Refuse bodies that decode larger
+#define HTTP_INFLATE_TIMEOUT_MS 10000      // Give up when the body stalls this long
+#define HTTP_INFLATE_HEAP_RESERVE 16384    // Left free besides working memory, for the result
+
+// Decodes a gzip or deflate (zlib) response body while it is read, using
+// the tinfl inflater in the ESP32 ROM. Working memory - the inflater
+// state and the 32 KB deflate window - is allocated for the call only;
+// decoded bytes are appended to the result as each window fills.
+class HttpInflate {
+public:
+    enum class Format : uint8_t {
+        NONE,
+        GZIP,
+        ZLIB
+    };
+
+    enum class Result : uint8_t {
+        OK,
+        FAILED,         // Corrupt, truncated or oversized body
+        NO_MEMORY       // Working memory couldn't be allocated
+    };
+
+    // From a Content-Encoding header value
+    static Format parseEncoding(const String& encoding);
+
+    // Whether the working memory fits in the heap right now. TLS leaves it
+    // fragmented, so check before asking for a compressed body.
+    static bool hasMemory();
+
+    // Read the body from `in` (contentLength < 0: until the server
+    // closes) and append the decoded text to `out`. `wireBytes` gets the
+    // number of bytes read.
+    static Result decode(Client& in, int contentLength, Format format,
+                         String& out, uint32_t& wireBytes);
+};
+
+#endif
@@ -33,6 +33,10 @@ public:
     static void saveSleepTimeout(int index);
     static int getSleepTimeoutIndex();
     static unsigned long getSleepTimeoutMs();
+    static uint32_t getSleepCount();
+    // esp_timer_get_time() to wake light sleep at, 0 for none. Wakes the
+    // display too, e.g. for the timer alarm.
+    static void setWakeAlarm(int64_t atUs);
 
 private:
     static bool currentState[NUM_BUTTONS];
@@ -41,6 +45,8 @@ private:
     static unsigned long lastActivity;
     static int sleepTimeoutIndex;
     static bool skipNextCallback;
+    static uint32_t sleepCount;
+    static volatile int64_t wakeAlarmAt;
     static ButtonCallback callback;
     static const uint8_t buttonPins[NUM_BUTTONS];
 };
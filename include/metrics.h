@@ -0,0 +1,73 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+
+#define METRICS_MAX 32
+#define METRICS_MAX_COLLECTORS 4
+#define METRICS_MAX_BUCKETS 12
+
+// Reads a counter or gauge at scrape time
+typedef double (*MetricReader)();
+// Writes a whole labelled family (per host, per app), HELP/TYPE included
+typedef void (*MetricCollector)(Print& out);
+
+// Fixed-bucket histogram, filled with Metrics::observe()
+struct Histogram {
+    const float* bounds;                         // Upper bounds, ascending; +Inf implied
+    uint8_t boundCount;
+    uint32_t buckets[METRICS_MAX_BUCKETS + 1];   // Per bucket, not cumulative
+    uint32_t count;
+    double sum;                                  // float stops adding small samples past 2^24
+};
+
+// Registry behind GET /metrics (Prometheus text format). Counters and
+// gauges are read through callbacks only when scraped, and histograms
+// are a few array increments, so nothing is spent while nobody scrapes.
+// Register at boot; the registry is never modified afterwards.
+class Metrics {
+public:
+    static void init();     // System metrics and the /metrics route
+
+    static void addCounter(const char* name, const char* help, MetricReader read);
+    static void addGauge(const char* name, const char* help, MetricReader read);
+    static void addHistogram(const char* name, const char* help, Histogram* h,
+                             const float* bounds, uint8_t boundCount);
+    static void addCollector(MetricCollector collect);
+
+    static void observe(Histogram& h, float value);
+
+    static void writeText(Print& out);
+
+    // Building blocks for collectors
+    static void writeFamily(Print& out, const char* name, const char* help, const char* type);
+    static void writeSample(Print& out, const char* name, const char* label,
+                            const char* labelValue, double value);
+
+private:
+    enum class Type : uint8_t {
+        COUNTER,
+        GAUGE,
+        HISTOGRAM
+    };
+
+    struct Entry {
+        const char* name;
+        const char* help;
+        Type type;
+        MetricReader read;
+        Histogram* histogram;
+    };
+
+    static Entry entries[METRICS_MAX];
+    static int entryCount;
+    static MetricCollector collectors[METRICS_MAX_COLLECTORS];
+    static int collectorCount;
+
+    static bool add(const char* name, const char* help, Type type,
+                    MetricReader read, Histogram* h);
+    static void writeHistogram(Print& out, const Entry& e);
+    static void writeHosts(Print& out);
+};
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef PREFETCH_QUEUE_H
+#define PREFETCH_QUEUE_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Fixed-size ring of parsed feed items. Apps pop from it on button presses
+// and top it up from update() once it drops to the low-water mark, so the
+// next item is normally ready before the user asks for it.
+template <typename T, uint8_t N>
+class PrefetchQueue {
+public:
+    // Parses up to `wanted` items into slots from nextFree()/commit().
+    // Returns the number of items added (0 on network or parse failure).
+    typedef int (*FillFn)(PrefetchQueue<T, N>& queue, int wanted);
+
+    explicit PrefetchQueue(FillFn fn, uint8_t low = PREFETCH_LOW_WATER)
+        : fill(fn), lowWater(low) {}
+
+    int count() const { return used; }
+    int capacity() const { return N; }
+    bool isEmpty() const { return used == 0; }
+    bool isFull() const { return used == N; }
+
+    // Take the oldest item
+    bool pop(T& out) {
+        if (used == 0) return false;
+        out = items[head];
+        head = (head + 1) % N;
+        used--;
+        lastPop = millis();
+        return true;
+    }
+
+    // Slot for the fill callback to parse into; nullptr when full
+    T* nextFree() {
+        if (used == N) return nullptr;
+        return &items[(head + used) % N];
+    }
+
+    // Publish the slot returned by nextFree()
+    void commit() {
+        if (used < N) used++;
+    }
+
+    void clear() {
+        head = 0;
+        used = 0;
+        refilling = false;
+    }
+
+    // True when a background top-up should run now. Waits a moment after
+    // a pop so the item just taken gets rendered first, and backs off
+    // after a failed fill.
+    bool wantsRefill() const {
+        if (used == N) return false;
+        if (!refilling && used > lowWater) return false;
+        unsigned long now = millis();
+        if (now - lastPop < PREFETCH_SETTLE_MS) return false;
+        if (lastFail && now - lastFail < PREFETCH_RETRY_MS) return false;
+        return true;
+    }
+
+    // Run one fill pass (may block for one HTTP round trip)
+    int refill() {
+        int added = fill(*this, N - used);
+        if (added <= 0) {
+            lastFail = millis();
+            if (lastFail == 0) lastFail = 1;
+            refilling = false;
+            return 0;
+        }
+        lastFail = 0;
+        // Keep going until full once started (single-item feeds need
+        // several passes to climb back from the low-water mark)
+        refilling = used < N;
+        return added;
+    }
+
+private:
+    T items[N];
+    uint8_t head = 0;
+    uint8_t used = 0;
+    FillFn fill;
+    uint8_t lowWater;
+    bool refilling = false;
+    unsigned long lastPop = 0;
+    unsigned long lastFail = 0;
+};
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef TEXT_CACHE_H
+#define TEXT_CACHE_H
+
+#include <Arduino.h>
+
+#define TEXT_CACHE_ENTRIES 32
+#define TEXT_CACHE_POOL_WORDS 1024      // 4 KB of bitmaps, one or two words per column
+#define TEXT_CACHE_KEY_LEN 40           // Longer text is drawn directly
+
+// Draws a cached layout with its left edge at x, in draw colour 1
+typedef void (*TextRaster)(int x, int baseline, const char* key);
+
+// Pre-rasterized strips for text drawn the same way every frame: title
+// and status bars, keyboard rows. An entry is the ink of one string (or
+// layout) in one font, one uint32_t per column, and a hit is a blit of
+// those words straight into the u8g2 page buffer instead of glyph
+// decoding. Least recently used entries make room for new ones.
+//
+// Blits match u8g2.drawStr in either font mode: in solid mode an entry
+// also keeps the pixels the glyph backgrounds cover, and a blit paints
+// them in the background colour.
+class TextCache {
+public:
+    // u8g2.drawStr() through the cache
+    static void drawStr(int x, int y, const char* text);
+    // u8g2.getStrWidth(), without measuring text drawn before
+    static int getStrWidth(const char* text);
+    // A layout drawn by raster(), cached by key and the current font
+    static void draw(int x, int y, const char* key, TextRaster raster, int width);
+
+    // Off draws everything directly, for A/B timing
+    static void setEnabled(bool on);
+
+    static uint32_t getHits();
+    static uint32_t getMisses();
+    static uint32_t getBytesUsed();
+
+private:
+    struct Entry {
+        const uint8_t* font;
+        TextRaster raster;      // nullptr for plain text
+        uint32_t hash;
+        char key[TEXT_CACHE_KEY_LEN];
+        uint32_t lastUsed;
+        uint16_t offset;        // First column in pool
+        uint8_t width;
+        uint8_t height;
+        int8_t top;             // First row, relative to the baseline
+        bool solid;             // Solid font mode: coverage columns follow the ink
+        bool used;
+    };
+
+    static Entry entries[TEXT_CACHE_ENTRIES];
+    static uint32_t pool[TEXT_CACHE_POOL_WORDS];
+    static uint16_t poolUsed;   // Words, including holes left by evictions
+    static uint32_t clock;
+    static uint32_t hits;
+    static uint32_t misses;
+    static bool enabled;
+
+    static int footprint(const Entry& e);
+    static Entry* find(const char* key, TextRaster raster);
+    static Entry* fetch(const char* key, TextRaster raster, int width);
+    static Entry* add(const char* key, TextRaster raster, int width);
+    static bool reserve(int words);
+    static void evict(Entry& e);
+    static void compact();
+    static bool blit(const Entry& e, int x, int y);
+};
+
+#endif
@@ -26,6 +26,13 @@ namespace UI {
     // Draw title bar
     void drawTitleBar(const char* title);
 
+    // Mark the title bar's content as cached/stale data
+    void drawStaleTag();
+
+    // Error-screen hint: "Retrying in Ns" while a host is backing off,
+    // otherwise the given hint
+    void drawRetryHint(int y, unsigned long retryMs, const char* hint);
+
     // Draw status bar (bottom)
     void drawStatusBar(const char* left, const char* right);
 
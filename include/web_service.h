@@ -0,0 +1,82 @@
+#ifndef WEB_SERVICE_H
+#define WEB_SERVICE_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+
+#define WEB_PORT 80
+#define WEB_MAX_CONNECTIONS 4          // Concurrent HTTP requests; more get 503
+#define WEB_MAX_WS_CLIENTS 6           // Per WebSocket endpoint, oldest dropped
+#define WEB_CLEANUP_MS 1000            // WebSocket housekeeping interval
+#define WEB_MAX_SOCKETS 4
+// Embedded pages live at fixed URLs, so a firmware update must reach the
+// browser within this lifetime; after it, the ETag makes a reload a 304
+#define WEB_ASSET_MAX_AGE 86400
+
+struct WebAsset;  // Generated into web_assets.h by scripts/embed_web.py
+
+// One async HTTP/WebSocket server on port 80 for the whole system.
+// Apps and services register their routes once at boot; the server
+// starts listening the first time WiFi connects and keeps serving no
+// matter which app is in the foreground.
+//
+// Handlers run on the AsyncTCP task, not in loop(): they must not
+// block, draw or beep. Hand anything heavier to the owner's update().
+class WebService {
+public:
+    static void init();     // Create the server and register the dashboard
+    static void update();   // Call from loop(): start on WiFi, housekeeping
+    static bool isRunning();
+
+    // Route registration. Requests beyond WEB_MAX_CONNECTIONS in flight
+    // are answered 503 before the handler runs.
+    static void on(const char* uri, WebRequestMethodComposite method,
+                   ArRequestHandlerFunction handler);
+    static void on(const char* uri, WebRequestMethodComposite method,
+                   ArRequestHandlerFunction handler, ArUploadHandlerFunction upload);
+    static void addWebSocket(AsyncWebSocket* ws);
+
+    // Serve a file from web/ at `uri`: pre-gzipped, streamed from flash,
+    // with ETag and Cache-Control
+    static void onAsset(const char* uri, const char* name);
+
+    // Reboot from loop() once the current response has gone out
+    static void scheduleRestart(unsigned long delayMs);
+
+    // Load figures, also shown on the dashboard
+    static uint32_t getRequestCount();
+    static uint32_t getRejectedCount();
+    static int getActiveCount();
+    static int getPeakActive();
+    static uint16_t getRequestRate();   // Requests/s over the last second
+    static uint16_t getPeakRate();
+
+private:
+    static AsyncWebServer* server;
+    static AsyncWebSocket* sockets[WEB_MAX_SOCKETS];
+    static int socketCount;
+    static bool running;
+
+    // Requests in flight; touched only from the AsyncTCP task
+    static AsyncWebServerRequest* admitted[WEB_MAX_CONNECTIONS];
+    static AsyncWebServerRequest* lastRejected;
+    static volatile int activeCount;
+    static volatile int peakActive;
+    static volatile uint32_t requestCount;
+    static volatile uint32_t rejectedCount;
+
+    static uint32_t rateBase;
+    static unsigned long rateAt;
+    static uint16_t rate;
+    static uint16_t peakRate;
+    static unsigned long lastCleanup;
+
+    static volatile bool restartPending;
+    static volatile unsigned long restartAt;
+
+    static bool admit(AsyncWebServerRequest* request);
+    static void sendAsset(AsyncWebServerRequest* request, const WebAsset* asset);
+    static void handleStatus(AsyncWebServerRequest* request);
+};
+
+#endif
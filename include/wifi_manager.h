@@ -4,18 +4,171 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include <Preferences.h>
+#include <lwip/dns.h>
 
-#define MAX_SAVED_NETWORKS 3
-#define MAX_SCAN_RESULTS 10
+#define MAX_SAVED_NETWORKS 16
+#define MAX_SCAN_RESULTS 24
+#define MAX_TRACKED_HOSTS 12
+#define NET_LOG_SIZE 32                // Recent requests kept for telemetry
 
+// DNS cache. lwIP doesn't hand out record TTLs, so entries live for a
+// fixed time; an expired entry is still used if a fresh lookup fails.
+#define DNS_CACHE_SIZE 12
+#define DNS_CACHE_TTL_MS 600000UL
+#define DNS_PREFETCH_TIMEOUT_MS 5000
+
+// Fast reconnect: how long a cached BSSID/channel/lease attempt may take
+// before falling back to a full scan + DHCP
+#define WIFI_FAST_ATTEMPT_MS 3000
+// Reuse the last DHCP lease as a static config on fast reconnects. Skips
+// DHCP entirely; disable if the router hands out short or changing leases.
+#define WIFI_REUSE_LEASE 1
+// Connect history that only nudges the ranking is written to NVS at most
+// this often, so a flapping AP doesn't wear the flash
+#define WIFI_NETS_SAVE_MS 600000
+
+// Connect from Settings: phase timeouts and the reachability probe
+#define WIFI_DHCP_TIMEOUT_MS 8000
+#define WIFI_INTERNET_CHECK_URL "http://connectivitycheck.gstatic.com/generate_204"
+#define WIFI_INTERNET_CHECK_MS 4000
+
+// Incremental scan: one channel per step so the UI keeps running
+#define WIFI_SCAN_CHANNELS 13
+#define WIFI_SCAN_DWELL_MS 120         // Active dwell per channel
+#define WIFI_SCAN_CACHE_MS 30000       // Reuse a scan younger than this
+
+// Per-host backoff / circuit breaker
+#define HOST_BACKOFF_BASE_MS 2000      // First retry delay after a failure
+#define HOST_BACKOFF_MAX_MS 300000     // Backoff cap (5 min)
+
+// Ask API servers for gzip/deflate bodies, decoded by HttpInflate.
+// Requests go out as HTTP/1.0 so bodies are never chunked.
+#define HTTP_ACCEPT_COMPRESSED 1
+#define HTTP_ERROR_DECODE (-20)        // Compressed body failed to decode
+#define HTTP_ERROR_NO_MEMORY (-21)     // No heap to decode it; not the host's fault
+
+// One SSID from a scan; several BSSIDs of the same SSID are merged,
+// keeping the strongest
 struct WiFiNetwork {
     char ssid[33];
     int32_t rssi;
     bool open;
+    uint8_t channel;
+    uint8_t bssid[6];
+    bool seen;          // Seen by the scan in progress (else left over from the last one)
+};
+
+// Per saved network: where we last associated and what lease we got,
+// so a reconnect can skip the channel scan (and DHCP). A static profile
+// is set by the user and is never overwritten by a learned lease.
+#define FC_VALID     0x01  // bssid/channel are known
+#define FC_HAS_LEASE 0x02  // ip/gateway/subnet/dns hold the last lease
+#define FC_STATIC    0x04  // ip/gateway/subnet/dns are a static profile
+
+struct FastConnectInfo {
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t flags;
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns;
+};
+
+// A saved network plus its connection history, used to rank candidates
+struct SavedNetwork {
+    char ssid[33];
+    char password[65];
+    FastConnectInfo fast;
+    uint32_t lastUsed;      // Connect sequence number of the last success (0 = never)
+    uint16_t successes;
+    uint16_t failures;      // Consecutive failed attempts, reset on success
+};
+
+// A saved network seen in the boot scan, strongest BSSID only
+struct ConnectCandidate {
+    int8_t index;           // Into the saved list
+    int32_t rssi;
+    uint8_t channel;        // 0 = unknown (scan failed), let begin() scan
+    uint8_t bssid[6];
+    int32_t score;
+};
+
+// Circuit breaker state for one API host. A failure opens the breaker
+// for an exponentially growing, jittered interval; requests fail fast
+// until it elapses, then a single half-open probe decides whether the
+// host is closed (healthy) again or backs off further.
+enum class HostState : uint8_t {
+    CLOSED,
+    OPEN,
+    HALF_OPEN
+};
+
+struct HostHealth {
+    char host[48];
+    HostState state;
+    uint8_t consecutiveFailures;
+    unsigned long retryAt;         // millis() when the breaker lets a probe through
+    unsigned long lastUsed;
+    uint32_t requests;             // Requests actually sent
+    uint32_t failures;             // Timeouts, connection errors, 5xx, 429
+    uint32_t rejected;             // Failed fast while the breaker was open
+
+    // Telemetry: sums over sent requests (divide by `requests` for averages)
+    uint32_t bytes;
+    uint32_t wireBytes;            // As received, before decompression
+    uint32_t dnsMs;
+    uint32_t connectMs;            // TCP connect, plus TLS handshake for https
+    uint32_t ttfbMs;               // Request sent until response headers parsed
+    uint32_t bodyMs;
+    uint32_t maxTotalMs;
+};
+
+struct DnsEntry {
+    char host[48];
+    uint32_t ip;
+    unsigned long resolvedAt;
+    unsigned long lastUsed;
+};
+
+struct DnsStats {
+    uint32_t hits;
+    uint32_t misses;               // Resolved on demand
+    uint32_t failures;             // Lookups that failed
+    uint32_t staleServed;          // Lookup failed, expired entry used instead
+    uint32_t prefetched;
+};
+
+// Timing breakdown of one request, newest kept in a ring buffer
+struct RequestRecord {
+    uint32_t at;                   // millis() when the request started
+    char host[32];
+    int16_t status;                // HTTP status, or negative HTTPClient error
+    uint8_t retries;               // Consecutive failures of the host before this request
+    uint16_t dnsMs;
+    uint16_t connectMs;
+    uint16_t ttfbMs;
+    uint16_t bodyMs;
+    uint32_t bytes;                // Response body size
+    uint32_t wireBytes;            // Body bytes received (compressed size if encoded)
+};
+
+// Progress of a connect started from Settings. The driver does 802.11
+// authentication, association and the WPA handshake in one go and only
+// reports the end of it, so those are a single JOINING phase.
+enum class ConnectPhase : uint8_t {
+    NONE,
+    WAITING,            // A scan is running; the join starts when it ends
+    JOINING,
+    DHCP,
+    INTERNET_CHECK,
+    DONE,
+    FAILED
 };
 
 enum class WiFiConnectState : uint8_t {
     IDLE,
+    SCANNING,               // Looking for saved networks in range
     CONNECTING,
     CONNECTED,
     FAILED_ALL
@@ -25,15 +178,29 @@ class WiFiManager {
 public:
     static void init();
 
-    // Scan for networks
-    static int scan();
+    // Async incremental scan. Results are merged into a deduplicated list,
+    // sorted by RSSI, as each channel completes. Returns false if a scan
+    // younger than WIFI_SCAN_CACHE_MS was reused instead (unless forced).
+    static bool startScan(bool force = false);
+    static bool isScanning();
+    static int getScanChannel();          // Channel in progress (0 = waiting to start)
+    static unsigned long getScanAge();    // ms since the last complete scan, ULONG_MAX if none
+    static uint32_t getScanVersion();     // Changes whenever the results change
     static WiFiNetwork* getScanResults();
     static int getScanCount();
 
-    // Connect to network (blocking, used by Settings UI)
-    static bool connect(const char* ssid, const char* password);
+    // Connect to a network chosen in Settings (non-blocking; progresses via
+    // update()). On success the network is saved; on failure or cancel the
+    // saved networks are tried again in the background.
+    static void connectAsync(const char* ssid, const char* password);
+    static void cancelConnect();
+    static ConnectPhase getConnectPhase();
+    static const char* getConnectError();   // Why the last connectAsync failed
+    static bool hasInternet();               // Result of the last reachability check
     static void disconnect();
     static bool isConnected();
+    // Whether httpGet can get an answer: connected, or replaying fixtures from disk
+    static bool canFetch();
 
     // Auto-connect to saved networks (non-blocking; progresses via update())
     static bool autoConnect();
@@ -54,25 +221,139 @@ public:
     static int getSavedCount();
     static const char* getSavedSSID(int index);
 
-    // HTTP helper for API calls
+    // Static IP profile for a saved network (ip == INADDR_NONE clears it)
+    static void setStaticIP(int index, IPAddress ip, IPAddress gateway,
+                            IPAddress subnet, IPAddress dns);
+
+    // HTTP helper for API calls. Returns "" on failure, immediately
+    // (without touching the network) while the host's breaker is open.
     static String httpGet(const char* url);
 
+    // Milliseconds until the host of `url` accepts requests again (0 = now)
+    static unsigned long getRetryDelay(const char* url);
+
+    // Failure statistics
+    static int getHostCount();
+    static const HostHealth* getHostHealth(int index);
+    static uint32_t getTotalFailures();
+    static uint32_t getConnectCount();    // Since boot
+    static uint32_t getDropCount();       // Connections lost (not user disconnects)
+
+    // Cached DNS resolution (also prefetched for known API hosts on connect)
+    static bool resolveHost(const char* host, IPAddress& ip);
+    static const DnsStats& getDnsStats();
+    static void flushDnsCache();
+
+    // Request telemetry. index 0 is the most recent request.
+    static int getRequestLogCount();
+    static const RequestRecord* getRequestLog(int index);
+    static uint32_t getTotalRequestBytes();
+    static uint32_t getTotalWireBytes();
+    static void dumpTelemetryCsv(Print& out);
+
 private:
     static Preferences prefs;
     static WiFiNetwork scanResults[MAX_SCAN_RESULTS];
     static int scanCount;
-    static char savedSSIDs[MAX_SAVED_NETWORKS][33];
-    static char savedPasswords[MAX_SAVED_NETWORKS][65];
+    static bool scanning;
+    static bool scanAnyOk;
+    static int scanChannel;
+    static unsigned long scanStepStart;
+    static unsigned long scanDoneAt;
+    static uint32_t scanVersion;
+    static SavedNetwork saved[MAX_SAVED_NETWORKS];
     static int savedCount;
+    static uint32_t connectSeq;
+    static bool netsDirty;              // Saved list changed since the last write
+    static unsigned long netsSavedAt;
     static char currentSSID[33];
 
     static WiFiConnectState connectState;
     static int connectingIndex;
     static unsigned long attemptStart;
+    static bool attemptFast;
+    static volatile unsigned long assocAt;
+    static volatile unsigned long gotIpAt;
+    static volatile unsigned long disconnectAt;
+    static volatile uint8_t disconnectReason;
+
+    static char manualSSID[33];
+    static char manualPass[65];
+    static ConnectPhase manualPhase;
+    static unsigned long phaseStart;
+    static char connectError[32];
+    static bool internetOk;
+    static volatile int8_t internetResult;    // -1 pending, 0 offline, 1 online
+    static volatile uint32_t checkGeneration;
+    static ConnectCandidate candidates[MAX_SAVED_NETWORKS];
+    static int candidateCount;
+    static int candidatePos;
+
+    static HostHealth hosts[MAX_TRACKED_HOSTS];
+    static int hostCount;
+    static uint32_t totalFailures;
+    static uint32_t connectCount;
+    static uint32_t dropCount;
+
+    static RequestRecord requestLog[NET_LOG_SIZE];
+    static int requestLogHead;     // Next slot to write
+    static int requestLogCount;
+    static uint32_t totalRequestBytes;
+    static uint32_t totalWireBytes;
+
+    static DnsEntry dnsCache[DNS_CACHE_SIZE];
+    static int dnsCount;
+    static DnsStats dnsStats;
+    static char dnsNetwork[33];    // SSID the cached answers came from
+    static int prefetchIndex;      // Next host to prefetch, -1 when idle
+    static bool prefetchPending;
+    static unsigned long prefetchStart;
+    static volatile bool prefetchDone;
+    static volatile uint32_t prefetchIp;
+    static volatile uint32_t prefetchGen;
 
     static void loadSavedNetworks();
     static void saveSavedNetworks();
-    static void beginAttempt(int index);
+    static void saveSavedNetworksThrottled();
+    static bool loadLegacyNetworks();
+    static void beginAttempt(int index, bool fast);
+    static void beginCandidate(int pos);
+    static void startCandidateScan();
+    static void rankCandidates();
+    static void updateScan();
+    static void beginScanStep();
+    static void mergeScanResults(int found);
+    static void finishScan();
+    static void recordAttempt(int index, bool success);
+    static int mostRecentSaved();
+    static void applyIPConfig(const FastConnectInfo* fc, bool useLease);
+    static void captureFastConnect(int index);
+    static void logConnectTiming(const char* ssid);
+    static int findSaved(const char* ssid);
+    static void onWiFiEvent(WiFiEvent_t event, WiFiEventInfo_t info);
+
+    static void updateManual();
+    static void beginManual();
+    static bool joinFailed();
+    static void startInternetCheck();
+    static void finishManual();
+    static void failManual(const char* reason);
+    static const char* describeReason(uint8_t reason);
+    static void internetCheckTask(void* arg);
+
+    static void parseHost(const char* url, char* host, size_t len);
+    static uint16_t parsePort(const char* url, bool* secure);
+    static void logRequest(const RequestRecord& rec, HostHealth* h);
+
+    static void onConnected();
+    static DnsEntry* findDns(const char* host);
+    static void storeDns(const char* host, uint32_t ip);
+    static void evictDns(const char* host);
+    static void updatePrefetch();
+    static void dnsFoundCallback(const char* name, const ip_addr_t* ipaddr, void* arg);
+    static HostHealth* findHost(const char* host, bool create);
+    static bool allowRequest(HostHealth* h);
+    static void recordResult(HostHealth* h, int httpCode);
 };
 
 #endif
@@ -0,0 +1,111 @@
+# PlatformIO pre-build step: minify and gzip web/* into include/web_assets.h
+#
+# Each file becomes a gzipped PROGMEM array plus an entry in WEB_ASSETS
+# (name, content type, ETag). WebService::onAsset() serves them with
+# Content-Encoding: gzip. The header is only rewritten when its content
+# changes, so unchanged assets don't trigger a rebuild.
+#
+# Also runs standalone: python scripts/embed_web.py
+
+import gzip
+import hashlib
+import os
+import re
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO
+    PROJECT_DIR = env["PROJECT_DIR"]  # noqa: F821
+except NameError:
+    PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+WEB_DIR = os.path.join(PROJECT_DIR, "web")
+OUT_PATH = os.path.join(PROJECT_DIR, "include", "web_assets.h")
+
+CONTENT_TYPES = {
+    ".html": "text/html",
+    ".js": "application/javascript",
+    ".css": "text/css",
+    ".json": "application/json",
+    ".svg": "image/svg+xml",
+}
+
+
+def minify(text, ext):
+    # Conservative: drop comments, indentation and blank lines, but keep
+    # line breaks so JS relying on automatic semicolons still parses
+    if ext == ".html":
+        text = re.sub(r"<!--.*?-->", "", text, flags=re.S)
+    if ext in (".html", ".css", ".js"):
+        text = re.sub(r"/\*.*?\*/", "", text, flags=re.S)
+    lines = [line.strip() for line in text.splitlines()]
+    return "\n".join(line for line in lines if line)
+
+
+def symbol(name):
+    return "WEB_" + re.sub(r"[^A-Za-z0-9]", "_", name).upper() + "_GZ"
+
+
+def build():
+    files = sorted(f for f in os.listdir(WEB_DIR)
+                   if os.path.splitext(f)[1] in CONTENT_TYPES)
+
+    out = [
+        "// Generated by scripts/embed_web.py from web/ - do not edit",
+        "#ifndef WEB_ASSETS_H",
+        "#define WEB_ASSETS_H",
+        "",
+        "#include <Arduino.h>",
+        "",
+        "struct WebAsset {",
+        "    const char* name;",
+        "    const char* type;",
+        "    const uint8_t* data;",
+        "    size_t len;",
+        "    const char* etag;",
+        "};",
+        "",
+    ]
+    entries = []
+    report = []
+
+    for name in files:
+        ext = os.path.splitext(name)[1]
+        with open(os.path.join(WEB_DIR, name), encoding="utf-8") as f:
+            raw = f.read()
+        small = minify(raw, ext).encode("utf-8")
+        # mtime=0 keeps the output (and the ETag) stable between builds
+        packed = gzip.compress(small, compresslevel=9, mtime=0)
+        etag = '\\"' + hashlib.sha1(packed).hexdigest()[:12] + '\\"'
+        sym = symbol(name)
+
+        out.append("// %s: %d -> %d minified -> %d gzipped"
+                   % (name, len(raw.encode("utf-8")), len(small), len(packed)))
+        out.append("static const uint8_t %s[] PROGMEM = {" % sym)
+        for i in range(0, len(packed), 16):
+            out.append("    " + ", ".join("0x%02x" % b for b in packed[i:i + 16]) + ",")
+        out.append("};")
+        out.append("")
+        entries.append('    {"%s", "%s", %s, sizeof(%s), "%s"},'
+                       % (name, CONTENT_TYPES[ext], sym, sym, etag))
+        report.append("%s %d -> %d B" % (name, len(raw), len(packed)))
+
+    out.append("static const WebAsset WEB_ASSETS[] = {")
+    out.extend(entries)
+    out.append("};")
+    out.append("static const int WEB_ASSET_COUNT = sizeof(WEB_ASSETS) / sizeof(WEB_ASSETS[0]);")
+    out.append("")
+    out.append("#endif")
+    out.append("")
+    text = "\n".join(out)
+
+    old = None
+    if os.path.exists(OUT_PATH):
+        with open(OUT_PATH, encoding="utf-8") as f:
+            old = f.read()
+    if text != old:
+        with open(OUT_PATH, "w", encoding="utf-8") as f:
+            f.write(text)
+        print("embed_web: " + ", ".join(report))
+
+
+build()
@@ -0,0 +1,151 @@
+# Stand-in server and compression report for recorded HTTP fixtures
+#
+# Copy /fx off the device (see "HTTP Fixtures" in PROJECT.md), then:
+#
+#   python scripts/fixture_server.py FX_DIR --report [--rate 20]
+#       Body and gzip size per endpoint, and how long each takes to
+#       transfer at --rate KB/s.
+#   python scripts/fixture_server.py FX_DIR [--port 8000] [--rate 20]
+#       Serve the fixtures at HTTP_FIXTURE_BASE_URL, gzipped when the
+#       request asks for it and paced to --rate KB/s (0 = unpaced) to
+#       stand in for a weak link.
+#   python scripts/fixture_server.py --compare OFF.csv ON.csv
+#       Wire bytes and average body time per host from two telemetry CSVs
+#       (System > Network, A), one taken with HTTP_ACCEPT_COMPRESSED 0 and
+#       one with 1.
+
+import argparse
+import csv
+import gzip
+import os
+import sys
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+GZIP_LEVEL = 6  # What most API servers use
+
+
+def strip_scheme(url):
+    return url.split("://", 1)[-1]
+
+
+def load_fixtures(fx_dir):
+    """URL without scheme -> (status, body bytes)"""
+    fixtures = {}
+    for name in sorted(os.listdir(fx_dir)):
+        if not name.endswith(".txt"):
+            continue
+        with open(os.path.join(fx_dir, name), "rb") as f:
+            data = f.read()
+        parts = data.split(b"\n", 2)
+        if len(parts) < 3:
+            continue
+        fixtures[strip_scheme(parts[1].decode())] = (int(parts[0]), parts[2])
+    return fixtures
+
+
+def endpoint(url):
+    return url.split("?", 1)[0]
+
+
+def transfer_ms(size, rate):
+    return size * 1000.0 / (rate * 1024) if rate else 0.0
+
+
+def report(fixtures, rate):
+    totals = {}
+    for url, (_, body) in fixtures.items():
+        t = totals.setdefault(endpoint(url), [0, 0, 0])
+        t[0] += 1
+        t[1] += len(body)
+        t[2] += len(gzip.compress(body, GZIP_LEVEL, mtime=0))
+
+    print("endpoint,fixtures,bytes,gzip_bytes,saved_pct,ms_at_rate,gzip_ms_at_rate")
+    for name, (count, raw, packed) in sorted(totals.items()):
+        saved = 100.0 * (raw - packed) / raw if raw else 0.0
+        print("%s,%d,%d,%d,%.0f,%.0f,%.0f" % (name, count, raw, packed, saved,
+                                             transfer_ms(raw, rate), transfer_ms(packed, rate)))
+
+
+def read_hosts(path):
+    """Per-host section of a telemetry CSV: host -> (wire_bytes, avg_body_ms)"""
+    hosts = {}
+    with open(path, newline="") as f:
+        section = None
+        for row in csv.reader(f):
+            if not row:
+                continue
+            if row[0] in ("at_ms", "host", "dns_hits"):
+                section = row[0]
+                header = row
+                continue
+            if section == "host":
+                rec = dict(zip(header, row))
+                hosts[rec["host"]] = (int(rec["wire_bytes"]), int(rec["avg_body_ms"]))
+    return hosts
+
+
+def compare(off_path, on_path):
+    off = read_hosts(off_path)
+    on = read_hosts(on_path)
+    print("host,wire_bytes_off,wire_bytes_on,saved_pct,avg_body_ms_off,avg_body_ms_on,saved_ms")
+    for host in sorted(set(off) & set(on)):
+        (wire_off, ms_off), (wire_on, ms_on) = off[host], on[host]
+        saved = 100.0 * (wire_off - wire_on) / wire_off if wire_off else 0.0
+        print("%s,%d,%d,%.0f,%d,%d,%d" % (host, wire_off, wire_on, saved, ms_off, ms_on,
+                                          ms_off - ms_on))
+
+
+def serve(fixtures, port, rate):
+    class Handler(BaseHTTPRequestHandler):
+        def do_GET(self):
+            # HttpFixtures::rewriteUrl: "<base>/<host>/<path>?q"
+            fixture = fixtures.get(self.path.lstrip("/"))
+            if not fixture:
+                self.send_error(404)
+                return
+            status, body = fixture
+            encoded = "gzip" in self.headers.get("Accept-Encoding", "")
+            if encoded:
+                body = gzip.compress(body, GZIP_LEVEL, mtime=0)
+
+            self.send_response(status)
+            self.send_header("Content-Type", "application/json")
+            self.send_header("Content-Length", str(len(body)))
+            if encoded:
+                self.send_header("Content-Encoding", "gzip")
+            self.end_headers()
+
+            # 1 KB at a time, paced to the link rate
+            for i in range(0, len(body), 1024):
+                self.wfile.write(body[i:i + 1024])
+                if rate:
+                    time.sleep(transfer_ms(len(body[i:i + 1024]), rate) / 1000.0)
+
+    print("Serving %d fixtures on port %d" % (len(fixtures), port))
+    ThreadingHTTPServer(("", port), Handler).serve_forever()
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("fx_dir", nargs="?")
+    parser.add_argument("--report", action="store_true")
+    parser.add_argument("--compare", nargs=2, metavar=("OFF_CSV", "ON_CSV"))
+    parser.add_argument("--port", type=int, default=8000)
+    parser.add_argument("--rate", type=float, default=20, help="KB/s, 0 = unpaced")
+    args = parser.parse_args()
+
+    if args.compare:
+        compare(*args.compare)
+        return
+    if not args.fx_dir:
+        parser.error("FX_DIR is required")
+    fixtures = load_fixtures(args.fx_dir)
+    if args.report:
+        report(fixtures, args.rate)
+    else:
+        serve(fixtures, args.port, args.rate)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
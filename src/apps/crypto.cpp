@@ -2,33 +2,71 @@
 #include "ui.h"
 #include "wifi_manager.h"
 #include "icons.h"
+#include "data_store.h"
 #include <ArduinoJson.h>
 
+static const char* PRICES_URL = "https://api.coingecko.com/api/v3/simple/price?ids=bitcoin,ethereum,solana&vs_currencies=usd&include_24hr_change=true";
+
+struct CryptoRecord {
+    float price[3];
+    float change[3];
+};
+
 void CryptoApp::init() {
     hasData = false;
     loading = false;
+    stale = false;
+    lastAttempt = 0;
     errorMsg[0] = '\0';
+    loadCached();
+}
+
+void CryptoApp::loadCached() {
+    CryptoRecord rec;
+    if (!DataStore::load("crypto", &rec, sizeof(rec), &cachedAt)) return;
+
+    btcPrice = rec.price[0];
+    ethPrice = rec.price[1];
+    solPrice = rec.price[2];
+    btcChange = rec.change[0];
+    ethChange = rec.change[1];
+    solChange = rec.change[2];
+    hasData = true;
+    stale = true;
+}
+
+void CryptoApp::saveCached() {
+    CryptoRecord rec = {
+        {btcPrice, ethPrice, solPrice},
+        {btcChange, ethChange, solChange}
+    };
+    DataStore::save("crypto", &rec, sizeof(rec));
 }
 
 void CryptoApp::update() {
-    // Auto-refresh every 60 seconds
-    if (hasData && millis() - lastFetch > 60000) {
-        fetchPrices();
-    }
+    // Refresh periodically while data is on screen; cached data and failed
+    // refreshes retry sooner, but never before the host's backoff expires
+    if (!hasData || !WiFiManager::canFetch()) return;
+    unsigned long interval = (stale || errorMsg[0]) ? 10000 : 60000;
+    if (lastAttempt != 0 && millis() - lastAttempt < interval) return;
+    if (WiFiManager::getRetryDelay(PRICES_URL) > 0) return;
+
+    fetchPrices();
+    if (stale) errorMsg[0] = '\0';  // Keep cached prices on screen
 }
 
 void CryptoApp::fetchPrices() {
-    if (!WiFiManager::isConnected()) {
+    if (!WiFiManager::canFetch()) {
         strcpy(errorMsg, "No WiFi");
         return;
     }
 
+    lastAttempt = millis();
+
     loading = true;
 
     // CoinGecko free API
-    const char* url = "https://api.coingecko.com/api/v3/simple/price?ids=bitcoin,ethereum,solana&vs_currencies=usd&include_24hr_change=true";
-
-    String response = WiFiManager::httpGet(url);
+    String response = WiFiManager::httpGet(PRICES_URL);
     loading = false;
 
     if (response.length() == 0) {
@@ -53,21 +91,22 @@ void CryptoApp::fetchPrices() {
     solChange = doc["solana"]["usd_24h_change"] | 0.0f;
 
     hasData = true;
+    stale = false;
     errorMsg[0] = '\0';
     lastFetch = millis();
+    saveCached();
 }
 
 void CryptoApp::render() {
     UI::clear();
     UI::drawTitleBar("Crypto Prices");
+    if (stale) UI::drawStaleTag();
 
     if (loading) {
         UI::drawCentered(35, "Loading...");
     } else if (strlen(errorMsg) > 0) {
         UI::drawCentered(30, errorMsg);
-        UI::setSmallFont();
-        UI::drawCentered(45, "Press A to retry");
-        UI::setNormalFont();
+        UI::drawRetryHint(45, WiFiManager::getRetryDelay(PRICES_URL), "Press A to retry");
     } else if (!hasData) {
         UI::drawCentered(35, "Press A to fetch");
     } else {
@@ -93,8 +132,14 @@ void CryptoApp::render() {
 
         // Last updated
         UI::setSmallFont();
-        unsigned long ago = (millis() - lastFetch) / 1000;
-        snprintf(buf, sizeof(buf), "Updated %lus ago", ago);
+        if (stale) {
+            char age[16];
+            DataStore::formatAge(cachedAt, age, sizeof(age));
+            snprintf(buf, sizeof(buf), "Saved %s", age);
+        } else {
+            unsigned long ago = (millis() - lastFetch) / 1000;
+            snprintf(buf, sizeof(buf), "Updated %lus ago", ago);
+        }
         u8g2.drawStr(4, 52, buf);
         UI::setNormalFont();
     }
@@ -2,58 +2,84 @@
 #include "ui.h"
 #include "wifi_manager.h"
 #include "icons.h"
+#include "data_store.h"
 #include <ArduinoJson.h>
 
 void FactsApp::init() {
     hasData = false;
     loading = false;
+    stale = false;
     errorMsg[0] = '\0';
-}
 
-void FactsApp::update() {
-    // No auto-refresh
+    // Show the last fact until a new one is requested
+    FactItem item;
+    if (DataStore::load("facts", &item, sizeof(item))) {
+        strcpy(fact, item.text);
+        hasData = true;
+        stale = true;
+    }
 }
 
-void FactsApp::fetchFact() {
-    if (!WiFiManager::isConnected()) {
-        strcpy(errorMsg, "No WiFi");
-        return;
+void FactsApp::update() {
+    // Top up the prefetch queue while the current fact is on screen
+    if (WiFiManager::canFetch() && queue.wantsRefill()) {
+        queue.refill();
     }
+}
 
-    loading = true;
+int FactsApp::fillQueue(PrefetchQueue<FactItem, PREFETCH_DEPTH>& q, int wanted) {
+    // Useless facts API has no batch endpoint: one fact per pass
+    FactItem* slot = q.nextFree();
+    if (!slot) return 0;
 
-    // Useless facts API
     String response = WiFiManager::httpGet("https://uselessfacts.jsph.pl/api/v2/facts/random?language=en");
-    loading = false;
-
-    if (response.length() == 0) {
-        strcpy(errorMsg, "Network error");
-        return;
-    }
+    if (response.length() == 0) return 0;
 
-    // Parse JSON
     StaticJsonDocument<512> doc;
     DeserializationError error = deserializeJson(doc, response);
-
-    if (error) {
-        strcpy(errorMsg, "Parse error");
-        return;
-    }
+    if (error) return 0;
 
     const char* text = doc["text"] | "";
-    strncpy(fact, text, sizeof(fact) - 1);
+    strncpy(slot->text, text, sizeof(slot->text) - 1);
+    slot->text[sizeof(slot->text) - 1] = '\0';
+    if (strlen(slot->text) == 0) return 0;
 
-    hasData = strlen(fact) > 0;
-    if (!hasData) {
-        strcpy(errorMsg, "No fact received");
-    } else {
-        errorMsg[0] = '\0';
+    q.commit();
+    return 1;
+}
+
+void FactsApp::fetchFact() {
+    if (queue.isEmpty()) {
+        if (!WiFiManager::canFetch()) {
+            strcpy(errorMsg, "No WiFi");
+            return;
+        }
+
+        // Nothing prefetched yet - fetch in the foreground
+        loading = true;
+        queue.refill();
+        loading = false;
+
+        if (queue.isEmpty()) {
+            strcpy(errorMsg, "Network error");
+            return;
+        }
     }
+
+    FactItem item;
+    queue.pop(item);
+    DataStore::save("facts", &item, sizeof(item));
+    strcpy(fact, item.text);
+
+    hasData = true;
+    stale = false;
+    errorMsg[0] = '\0';
 }
 
 void FactsApp::render() {
     UI::clear();
     UI::drawTitleBar("Random Fact");
+    if (stale) UI::drawStaleTag();
 
     if (loading) {
         UI::drawCentered(35, "Loading...");
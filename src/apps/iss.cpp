@@ -2,32 +2,73 @@
 #include "ui.h"
 #include "wifi_manager.h"
 #include "icons.h"
+#include "data_store.h"
 #include <ArduinoJson.h>
 
+static const char* ISS_NOW_URL = "http://api.open-notify.org/iss-now.json";
+
+struct ISSRecord {
+    float latitude;
+    float longitude;
+    int32_t astronautCount;
+    char astronauts[6][32];
+};
+
 void ISSApp::init() {
     hasData = false;
     loading = false;
+    stale = false;
+    lastAttempt = 0;
     errorMsg[0] = '\0';
     astronautCount = 0;
+    loadCached();
+}
+
+void ISSApp::loadCached() {
+    ISSRecord rec;
+    if (!DataStore::load("iss", &rec, sizeof(rec), &cachedAt)) return;
+
+    latitude = rec.latitude;
+    longitude = rec.longitude;
+    astronautCount = rec.astronautCount;
+    memcpy(astronauts, rec.astronauts, sizeof(astronauts));
+    hasData = true;
+    stale = true;
+}
+
+void ISSApp::saveCached() {
+    ISSRecord rec;
+    rec.latitude = latitude;
+    rec.longitude = longitude;
+    rec.astronautCount = astronautCount;
+    memcpy(rec.astronauts, astronauts, sizeof(rec.astronauts));
+    DataStore::save("iss", &rec, sizeof(rec));
 }
 
 void ISSApp::update() {
-    // Auto-refresh every 30 seconds
-    if (hasData && millis() - lastFetch > 30000) {
-        fetchISS();
-    }
+    // Refresh periodically while data is on screen; cached data and failed
+    // refreshes retry sooner, but never before the host's backoff expires
+    if (!hasData || !WiFiManager::canFetch()) return;
+    unsigned long interval = (stale || errorMsg[0]) ? 10000 : 30000;
+    if (lastAttempt != 0 && millis() - lastAttempt < interval) return;
+    if (WiFiManager::getRetryDelay(ISS_NOW_URL) > 0) return;
+
+    fetchISS();
+    if (stale) errorMsg[0] = '\0';  // Keep cached position on screen
 }
 
 void ISSApp::fetchISS() {
-    if (!WiFiManager::isConnected()) {
+    if (!WiFiManager::canFetch()) {
         strcpy(errorMsg, "No WiFi");
         return;
     }
 
+    lastAttempt = millis();
+
     loading = true;
 
     // ISS Location API
-    String response = WiFiManager::httpGet("http://api.open-notify.org/iss-now.json");
+    String response = WiFiManager::httpGet(ISS_NOW_URL);
 
     if (response.length() == 0) {
         loading = false;
@@ -48,14 +89,16 @@ void ISSApp::fetchISS() {
     latitude = doc["iss_position"]["latitude"].as<float>();
     longitude = doc["iss_position"]["longitude"].as<float>();
 
+    // Also fetch astronauts (only once per launch; a cached crew is refreshed)
+    if (astronautCount == 0 || stale) {
+        fetchAstronauts();
+    }
+
     hasData = true;
+    stale = false;
     errorMsg[0] = '\0';
     lastFetch = millis();
-
-    // Also fetch astronauts (only once)
-    if (astronautCount == 0) {
-        fetchAstronauts();
-    }
+    saveCached();
 
     loading = false;
 }
@@ -86,14 +129,13 @@ void ISSApp::fetchAstronauts() {
 void ISSApp::render() {
     UI::clear();
     UI::drawTitleBar("ISS Tracker");
+    if (stale) UI::drawStaleTag();
 
     if (loading) {
         UI::drawCentered(35, "Loading...");
     } else if (strlen(errorMsg) > 0) {
         UI::drawCentered(30, errorMsg);
-        UI::setSmallFont();
-        UI::drawCentered(45, "Press A to retry");
-        UI::setNormalFont();
+        UI::drawRetryHint(45, WiFiManager::getRetryDelay(ISS_NOW_URL), "Press A to retry");
     } else if (!hasData) {
         UI::drawCentered(35, "Press A to track");
     } else {
@@ -112,8 +154,14 @@ void ISSApp::render() {
 
         // Last updated
         UI::setSmallFont();
-        unsigned long ago = (millis() - lastFetch) / 1000;
-        snprintf(buf, sizeof(buf), "Updated %lus ago", ago);
+        if (stale) {
+            char age[16];
+            DataStore::formatAge(cachedAt, age, sizeof(age));
+            snprintf(buf, sizeof(buf), "Saved %s", age);
+        } else {
+            unsigned long ago = (millis() - lastFetch) / 1000;
+            snprintf(buf, sizeof(buf), "Updated %lus ago", ago);
+        }
         u8g2.drawStr(4, 52, buf);
         UI::setNormalFont();
     }
@@ -2,76 +2,128 @@
 #include "ui.h"
 #include "wifi_manager.h"
 #include "icons.h"
+#include "data_store.h"
 #include <ArduinoJson.h>
 
 void JokesApp::init() {
     hasData = false;
     loading = false;
     showPunchline = false;
+    stale = false;
     errorMsg[0] = '\0';
+
+    // Show the last joke until a new one is requested
+    JokeItem item;
+    if (DataStore::load("jokes", &item, sizeof(item))) {
+        isSingleJoke = item.single;
+        strcpy(setup, item.setup);
+        strcpy(delivery, item.delivery);
+        hasData = true;
+        stale = true;
+    }
 }
 
 void JokesApp::update() {
-    // No auto-refresh
+    // Top up the prefetch queue while the current joke is on screen
+    if (WiFiManager::canFetch() && queue.wantsRefill()) {
+        queue.refill();
+    }
 }
 
-void JokesApp::fetchJoke() {
-    if (!WiFiManager::isConnected()) {
-        strcpy(errorMsg, "No WiFi");
-        return;
+static bool parseJoke(JsonObject j, JokeItem* item) {
+    const char* type = j["type"] | "single";
+    item->single = (strcmp(type, "single") == 0);
+
+    if (item->single) {
+        const char* joke = j["joke"] | "";
+        strncpy(item->setup, joke, sizeof(item->setup) - 1);
+        item->setup[sizeof(item->setup) - 1] = '\0';
+        item->delivery[0] = '\0';
+    } else {
+        const char* s = j["setup"] | "";
+        const char* d = j["delivery"] | "";
+        strncpy(item->setup, s, sizeof(item->setup) - 1);
+        item->setup[sizeof(item->setup) - 1] = '\0';
+        strncpy(item->delivery, d, sizeof(item->delivery) - 1);
+        item->delivery[sizeof(item->delivery) - 1] = '\0';
     }
 
-    loading = true;
-    showPunchline = false;
+    return strlen(item->setup) > 0;
+}
 
-    // JokeAPI
-    String response = WiFiManager::httpGet("https://v2.jokeapi.dev/joke/Any?safe-mode");
-    loading = false;
+int JokesApp::fillQueue(PrefetchQueue<JokeItem, PREFETCH_DEPTH>& q, int wanted) {
+    // JokeAPI returns up to 10 jokes per request
+    char url[80];
+    snprintf(url, sizeof(url), "https://v2.jokeapi.dev/joke/Any?safe-mode&amount=%d", wanted);
 
-    if (response.length() == 0) {
-        strcpy(errorMsg, "Network error");
-        return;
-    }
+    String response = WiFiManager::httpGet(url);
+    if (response.length() == 0) return 0;
 
-    // Parse JSON
-    StaticJsonDocument<1024> doc;
+    DynamicJsonDocument doc(1024 * PREFETCH_DEPTH);
     DeserializationError error = deserializeJson(doc, response);
-
-    if (error) {
-        strcpy(errorMsg, "Parse error");
-        return;
+    if (error) return 0;
+
+    if (doc["error"] == true) return 0;
+
+    int added = 0;
+    if (doc.containsKey("jokes")) {
+        for (JsonObject j : doc["jokes"].as<JsonArray>()) {
+            JokeItem* slot = q.nextFree();
+            if (!slot) break;
+            if (parseJoke(j, slot)) {
+                q.commit();
+                added++;
+            }
+        }
+    } else {
+        // amount=1 returns a bare joke object
+        JokeItem* slot = q.nextFree();
+        if (slot && parseJoke(doc.as<JsonObject>(), slot)) {
+            q.commit();
+            added++;
+        }
     }
 
-    if (doc.containsKey("error") && doc["error"] == true) {
-        strcpy(errorMsg, "API error");
-        return;
-    }
+    return added;
+}
 
-    const char* type = doc["type"] | "single";
-    isSingleJoke = (strcmp(type, "single") == 0);
+void JokesApp::fetchJoke() {
+    showPunchline = false;
 
-    if (isSingleJoke) {
-        const char* joke = doc["joke"] | "";
-        strncpy(setup, joke, sizeof(setup) - 1);
-        delivery[0] = '\0';
-    } else {
-        const char* s = doc["setup"] | "";
-        const char* d = doc["delivery"] | "";
-        strncpy(setup, s, sizeof(setup) - 1);
-        strncpy(delivery, d, sizeof(delivery) - 1);
-    }
+    if (queue.isEmpty()) {
+        if (!WiFiManager::canFetch()) {
+            strcpy(errorMsg, "No WiFi");
+            return;
+        }
 
-    hasData = strlen(setup) > 0;
-    if (!hasData) {
-        strcpy(errorMsg, "No joke received");
-    } else {
-        errorMsg[0] = '\0';
+        // Nothing prefetched yet - fetch in the foreground
+        loading = true;
+        queue.refill();
+        loading = false;
+
+        if (queue.isEmpty()) {
+            strcpy(errorMsg, "Network error");
+            return;
+        }
     }
+
+    JokeItem item;
+    queue.pop(item);
+    DataStore::save("jokes", &item, sizeof(item));
+
+    isSingleJoke = item.single;
+    strcpy(setup, item.setup);
+    strcpy(delivery, item.delivery);
+
+    hasData = true;
+    stale = false;
+    errorMsg[0] = '\0';
 }
 
 void JokesApp::render() {
     UI::clear();
     UI::drawTitleBar("Jokes");
+    if (stale) UI::drawStaleTag();
 
     if (loading) {
         UI::drawCentered(35, "Loading...");
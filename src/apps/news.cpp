@@ -2,30 +2,69 @@
 #include "ui.h"
 #include "wifi_manager.h"
 #include "icons.h"
+#include "data_store.h"
 #include <ArduinoJson.h>
 #include <Preferences.h>
 
+static const char* NEWS_HOST_URL = "https://newsapi.org/";
+
+struct NewsRecord {
+    char headlines[MAX_HEADLINES][80];
+    char sources[MAX_HEADLINES][24];
+    int32_t count;
+};
+
 void NewsApp::init() {
     hasData = false;
     loading = false;
+    stale = false;
+    lastAttempt = 0;
     errorMsg[0] = '\0';
     currentIndex = 0;
     headlineCount = 0;
+    loadCached();
+}
+
+void NewsApp::loadCached() {
+    NewsRecord rec;
+    if (!DataStore::load("news", &rec, sizeof(rec))) return;
+    if (rec.count <= 0 || rec.count > MAX_HEADLINES) return;
+
+    memcpy(headlines, rec.headlines, sizeof(headlines));
+    memcpy(sources, rec.sources, sizeof(sources));
+    headlineCount = rec.count;
+    hasData = true;
+    stale = true;
+}
+
+void NewsApp::saveCached() {
+    NewsRecord rec;
+    memcpy(rec.headlines, headlines, sizeof(rec.headlines));
+    memcpy(rec.sources, sources, sizeof(rec.sources));
+    rec.count = headlineCount;
+    DataStore::save("news", &rec, sizeof(rec));
 }
 
 void NewsApp::update() {
-    // Auto-refresh every 10 minutes
-    if (hasData && millis() - lastFetch > 600000) {
-        fetchNews();
-    }
+    // Refresh periodically while data is on screen; cached data and failed
+    // refreshes retry sooner, but never before the host's backoff expires
+    if (!hasData || !WiFiManager::canFetch()) return;
+    unsigned long interval = (stale || errorMsg[0]) ? 10000 : 600000;
+    if (lastAttempt != 0 && millis() - lastAttempt < interval) return;
+    if (WiFiManager::getRetryDelay(NEWS_HOST_URL) > 0) return;
+
+    fetchNews();
+    if (stale) errorMsg[0] = '\0';  // Keep cached headlines on screen
 }
 
 void NewsApp::fetchNews() {
-    if (!WiFiManager::isConnected()) {
+    if (!WiFiManager::canFetch()) {
         strcpy(errorMsg, "No WiFi");
         return;
     }
 
+    lastAttempt = millis();
+
     // Get API key (use default from config if NVS is empty)
     Preferences prefs;
     prefs.begin(NVS_NAMESPACE, true);
@@ -72,8 +111,13 @@ void NewsApp::fetchNews() {
         return;
     }
 
-    // Extract headlines
+    // Extract headlines (an empty result leaves cached headlines alone)
     JsonArray articles = doc["articles"];
+    if (articles.size() == 0) {
+        strcpy(errorMsg, "No headlines");
+        return;
+    }
+
     headlineCount = 0;
 
     for (JsonObject article : articles) {
@@ -83,16 +127,16 @@ void NewsApp::fetchNews() {
         const char* source = article["source"]["name"] | "";
 
         strncpy(headlines[headlineCount], title, sizeof(headlines[0]) - 1);
+        headlines[headlineCount][sizeof(headlines[0]) - 1] = '\0';
         strncpy(sources[headlineCount], source, sizeof(sources[0]) - 1);
+        sources[headlineCount][sizeof(sources[0]) - 1] = '\0';
         headlineCount++;
     }
 
     hasData = headlineCount > 0;
-    if (!hasData) {
-        strcpy(errorMsg, "No headlines");
-    } else {
-        errorMsg[0] = '\0';
-    }
+    stale = false;
+    errorMsg[0] = '\0';
+    saveCached();
 
     currentIndex = 0;
     lastFetch = millis();
@@ -101,14 +145,13 @@ void NewsApp::fetchNews() {
 void NewsApp::render() {
     UI::clear();
     UI::drawTitleBar("News");
+    if (stale) UI::drawStaleTag();
 
     if (loading) {
         UI::drawCentered(35, "Loading...");
     } else if (strlen(errorMsg) > 0) {
         UI::drawCentered(30, errorMsg);
-        UI::setSmallFont();
-        UI::drawCentered(45, "Press A to fetch");
-        UI::setNormalFont();
+        UI::drawRetryHint(45, WiFiManager::getRetryDelay(NEWS_HOST_URL), "Press A to fetch");
     } else if (!hasData) {
         UI::drawCentered(35, "Press A to fetch");
     } else {
@@ -3,128 +3,155 @@
 #include "input.h"
 #include "icons.h"
 #include "wifi_manager.h"
-#include <WebSocketsServer.h>
-#include <WebServer.h>
-
-// Static instance for WebSocket callback
-static PongApp* pongInstance = nullptr;
-static WebServer* httpServer = nullptr;
-
-// Embedded HTML page for Player 2 (~2KB)
-static const char PLAYER2_HTML[] PROGMEM = R"rawliteral(
-<!DOCTYPE html>
-<html>
-<head>
-<meta name="viewport" content="width=device-width,initial-scale=1,user-scalable=no">
-<title>Pong P2</title>
-<style>
-*{margin:0;padding:0;box-sizing:border-box}
-body{background:#111;color:#fff;font-family:sans-serif;display:flex;flex-direction:column;align-items:center;height:100vh;padding:10px;overflow:hidden}
-h1{font-size:18px;margin:5px 0}
-#score{font-size:24px;margin:5px 0}
-canvas{border:1px solid #444;background:#000;margin:10px 0}
-#status{font-size:14px;color:#888;margin:5px 0}
-.controls{display:flex;gap:20px;margin:10px 0}
-.btn{width:80px;height:80px;border-radius:50%;border:none;font-size:32px;cursor:pointer;display:flex;align-items:center;justify-content:center;user-select:none;-webkit-user-select:none;touch-action:manipulation}
-.btn-up{background:#2a5;color:#fff}
-.btn-down{background:#25a;color:#fff}
-.btn:active{opacity:0.7}
-#ready{background:#e82;color:#fff;border:none;padding:15px 40px;font-size:18px;border-radius:8px;cursor:pointer;margin:10px 0;display:none}
-#ready:active{opacity:0.7}
-</style>
-</head>
-<body>
-<h1>PONG - Player 2</h1>
-<div id="score">0 - 0</div>
-<canvas id="c" width="256" height="128"></canvas>
-<div id="status">Connecting...</div>
-<button id="ready">READY</button>
-<div class="controls">
-<button class="btn btn-up" id="up">&#9650;</button>
-<button class="btn btn-down" id="down">&#9660;</button>
-</div>
-<script>
-var ws,ctx=document.getElementById('c').getContext('2d');
-var st={p1:26,p2:26,bx:64,by:32,s1:0,s2:0,state:0};
-var connected=false,playing=false;
-function draw(){
-ctx.fillStyle='#000';ctx.fillRect(0,0,256,128);
-ctx.fillStyle='#fff';
-ctx.setLineDash([8,8]);ctx.beginPath();ctx.moveTo(128,0);ctx.lineTo(128,128);ctx.strokeStyle='#444';ctx.stroke();
-ctx.fillRect(8,st.p1*2,6,24);
-ctx.fillRect(242,st.p2*2,6,24);
-ctx.fillRect(st.bx*2,st.by*2,6,6);
-document.getElementById('score').textContent=st.s1+' - '+st.s2;
-}
-function connect(){
-var h=location.hostname;
-ws=new WebSocket('ws://'+h+':81/');
-ws.onopen=function(){
-connected=true;
-document.getElementById('status').textContent='Connected - Press READY';
-document.getElementById('ready').style.display='block';
+#include "web_service.h"
+#include "metrics.h"
+#include "audio.h"
+
+// Player 2 socket on the shared web server. It stays registered; the
+// lobby flag decides whether connections are accepted.
+static AsyncWebSocket pongSocket("/pong/ws");
+static volatile bool lobbyOpen = false;
+
+// State frame sent to P2 at 30 Hz, little endian:
+//   [0]    FRAME_VERSION << 6 | field mask
+//   [1]    sequence number
+//   [2..3] device time, ms (wraps), for interpolation on the page
+// then only the fields in the mask, in bit order:
+//   F_P1     P1 paddle y, px                      1 byte
+//   F_P2     P2 paddle y, px                      1 byte
+//   F_BALL   ball x, y in 1/16 px, 12 bits each   3 bytes
+//   F_SCORE  p1 << 4 | p2                         1 byte
+//   F_STATE  game state << 6 | ack                1 byte
+//            (0 waiting, 1 playing, 2 game over; the ack is the last P2
+//            input sequence applied)
+// Unchanged fields are left out. A keyframe with every field (11 bytes)
+// goes out to a new client, to one that missed a frame, and to everyone
+// every FRAME_KEY_EVERY frames. Between keyframes the ack travels when it
+// changes, so P2 can time its inputs.
+//
+// P2 sends text 'R' (ready) and a binary input frame on every button
+// press or release: 'I', sequence (0..63), held buttons (HOLD_UP |
+// HOLD_DOWN).
+// Later connections are spectators: they get text 'S' once, then the
+// same frames, and anything they send is ignored.
+static const uint8_t FRAME_VERSION = 3;
+static const uint8_t F_P1 = 0x01;
+static const uint8_t F_P2 = 0x02;
+static const uint8_t F_BALL = 0x04;
+static const uint8_t F_SCORE = 0x08;
+static const uint8_t F_STATE = 0x10;
+static const uint8_t FRAME_KEY_EVERY = 30;
+static const size_t FRAME_MAX = 11;
+static const uint8_t ACK_MASK = 0x3F;
+static const uint8_t HOLD_UP = 0x01;      // Held buttons, for both players
+static const uint8_t HOLD_DOWN = 0x02;
+static const unsigned long PING_INTERVAL_MS = 1000;   // RTT probe while P2 is connected
+static const size_t MAX_QUEUED_FRAMES = 2;    // Per client; beyond this frames are dropped
+
+// Physics is integer fixed point with 8 fraction bits (1/256 px), stepped
+// at a fixed 60 Hz. Same inputs, same game: nothing depends on float
+// rounding or on how long a loop() iteration took.
+static const int FP_SHIFT = 8;
+static const int32_t FP_ONE = 1 << FP_SHIFT;
+static const uint32_t TICK_US = 16667;
+static const uint32_t MAX_CATCH_UP_TICKS = 4;   // Longer stalls drop time
+static const int PADDLE_STEP = 3;               // px per tick
+static const int32_t BALL_MAX_VX = 8 << FP_SHIFT;
+static const int32_t BALL_MAX_VY = 4 << FP_SHIFT;
+
+// Serve directions at 2 px/tick, 0..45 degrees in 5 degree steps:
+// cos and sin scaled by 2 * FP_ONE
+static const int16_t SERVE_DIRS[][2] = {
+    {512, 0}, {510, 45}, {504, 89}, {495, 133}, {481, 175},
+    {464, 216}, {443, 256}, {419, 294}, {392, 329}, {362, 362},
 };
-ws.onclose=function(){
-connected=false;playing=false;
-document.getElementById('status').textContent='Disconnected';
-document.getElementById('ready').style.display='none';
-setTimeout(connect,2000);
+static const int SERVE_DIR_COUNT = sizeof(SERVE_DIRS) / sizeof(SERVE_DIRS[0]);
+
+// stepPhysics() results, for sounds
+static const uint8_t EV_WALL = 0x01;
+static const uint8_t EV_PADDLE = 0x02;
+static const uint8_t EV_P1_SCORED = 0x04;
+static const uint8_t EV_P2_SCORED = 0x08;
+
+// Step cost and time lost to stalls, exported on /metrics
+static Histogram tickHistogram;
+static const float TICK_BUCKETS_US[] = {5, 10, 20, 50, 100, 200};
+static uint32_t ticksDropped = 0;
+
+// Send cost and bandwidth, exported on /metrics
+static Histogram sendHistogram;
+static const float SEND_BUCKETS_US[] = {50, 100, 200, 500, 1000, 2000, 5000};
+static uint32_t framesSent = 0;
+static uint32_t frameBytesSent = 0;
+static uint32_t framesDropped = 0;
+
+// Socket events arrive on the web server task and are queued for update()
+struct NetEvent {
+    uint32_t clientId;
+    AwsEventType type;
+    char cmd;           // 'R', 'I' input frame, 'P' ping answered
+    uint8_t seq;
+    uint8_t held;
+    uint32_t value;     // 'P': round trip, ms
 };
-ws.onmessage=function(e){
-try{
-var d=JSON.parse(e.data);
-st.p1=d.p1;st.p2=d.p2;st.bx=d.bx;st.by=d.by;st.s1=d.s1;st.s2=d.s2;st.state=d.st;
-if(d.st==3)playing=true;
-if(d.st==4){
-playing=false;
-document.getElementById('status').textContent=(st.s2>st.s1)?'You Win!':'You Lose';
-document.getElementById('ready').style.display='block';
-document.getElementById('ready').textContent='REMATCH';
-}else if(playing){
-document.getElementById('status').textContent='Playing';
-document.getElementById('ready').style.display='none';
+static const int NET_QUEUE_SIZE = 32;
+static NetEvent netQueue[NET_QUEUE_SIZE];
+static int netHead = 0;
+static int netTail = 0;
+static portMUX_TYPE netMux = portMUX_INITIALIZER_UNLOCKED;
+
+static void pushNetEvent(uint32_t clientId, AwsEventType type, char cmd,
+                         uint8_t seq = 0, uint8_t held = 0, uint32_t value = 0) {
+    portENTER_CRITICAL(&netMux);
+    int next = (netHead + 1) % NET_QUEUE_SIZE;
+    if (next != netTail) {  // Full: drop (paddle input is resent anyway)
+        netQueue[netHead] = {clientId, type, cmd, seq, held, value};
+        netHead = next;
+    }
+    portEXIT_CRITICAL(&netMux);
 }
-draw();
-}catch(ex){}
-};
+
+static bool popNetEvent(NetEvent& ev) {
+    bool got = false;
+    portENTER_CRITICAL(&netMux);
+    if (netTail != netHead) {
+        ev = netQueue[netTail];
+        netTail = (netTail + 1) % NET_QUEUE_SIZE;
+        got = true;
+    }
+    portEXIT_CRITICAL(&netMux);
+    return got;
+}
+
+void PongApp::registerRoutes() {
+    pongSocket.onEvent(wsEventHandler);
+    WebService::addWebSocket(&pongSocket);
+    WebService::onAsset("/pong", "pong.html");
+
+    Metrics::addHistogram("pong_frame_send_us", "Encode and queue time of one state frame, all clients",
+                          &sendHistogram, SEND_BUCKETS_US,
+                          sizeof(SEND_BUCKETS_US) / sizeof(SEND_BUCKETS_US[0]));
+    Metrics::addCounter("pong_frames_sent_total", "State frames sent to P2 and spectators",
+                        []() -> double { return framesSent; });
+    Metrics::addCounter("pong_frame_bytes_total", "State frame payload bytes sent",
+                        []() -> double { return frameBytesSent; });
+    Metrics::addCounter("pong_frames_dropped_total", "Frames skipped for clients with a full queue",
+                        []() -> double { return framesDropped; });
+    Metrics::addGauge("pong_clients", "Connected P2 and spectator sockets",
+                      []() -> double { return pongSocket.count(); });
+    Metrics::addHistogram("pong_tick_us", "Time of one physics tick",
+                          &tickHistogram, TICK_BUCKETS_US,
+                          sizeof(TICK_BUCKETS_US) / sizeof(TICK_BUCKETS_US[0]));
+    Metrics::addCounter("pong_ticks_dropped_total", "Physics ticks skipped after a stall",
+                        []() -> double { return ticksDropped; });
 }
-function send(c){if(ws&&ws.readyState==1)ws.send(c);}
-var upInt,downInt;
-document.getElementById('up').addEventListener('touchstart',function(e){e.preventDefault();send('U');upInt=setInterval(function(){send('U');},50);});
-document.getElementById('up').addEventListener('touchend',function(){clearInterval(upInt);});
-document.getElementById('up').addEventListener('mousedown',function(){send('U');upInt=setInterval(function(){send('U');},50);});
-document.getElementById('up').addEventListener('mouseup',function(){clearInterval(upInt);});
-document.getElementById('up').addEventListener('mouseleave',function(){clearInterval(upInt);});
-document.getElementById('down').addEventListener('touchstart',function(e){e.preventDefault();send('D');downInt=setInterval(function(){send('D');},50);});
-document.getElementById('down').addEventListener('touchend',function(){clearInterval(downInt);});
-document.getElementById('down').addEventListener('mousedown',function(){send('D');downInt=setInterval(function(){send('D');},50);});
-document.getElementById('down').addEventListener('mouseup',function(){clearInterval(downInt);});
-document.getElementById('down').addEventListener('mouseleave',function(){clearInterval(downInt);});
-document.getElementById('ready').addEventListener('click',function(){send('R');});
-var upKey=false,downKey=false;
-document.addEventListener('keydown',function(e){
-if(e.key=='ArrowUp'||e.key=='w'||e.key=='W'){e.preventDefault();if(!upKey){upKey=true;send('U');upInt=setInterval(function(){send('U');},50);}}
-if(e.key=='ArrowDown'||e.key=='s'||e.key=='S'){e.preventDefault();if(!downKey){downKey=true;send('D');downInt=setInterval(function(){send('D');},50);}}
-if(e.key=='r'||e.key=='R'||e.key==' '||e.key=='Enter'){e.preventDefault();send('R');}
-});
-document.addEventListener('keyup',function(e){
-if(e.key=='ArrowUp'||e.key=='w'||e.key=='W'){upKey=false;clearInterval(upInt);}
-if(e.key=='ArrowDown'||e.key=='s'||e.key=='S'){downKey=false;clearInterval(downInt);}
-});
-draw();connect();
-</script>
-</body>
-</html>
-)rawliteral";
 
 void PongApp::init() {
     state = State::MENU;
-    pongInstance = this;
 }
 
 void PongApp::onClose() {
     stopWebSocketServer();
-    pongInstance = nullptr;
 }
 
 void PongApp::startGame() {
@@ -132,41 +159,54 @@ void PongApp::startGame() {
     aiY = 26;
     playerScore = 0;
     aiScore = 0;
-    aiSpeed = 1.5;
+    aiSpeed = 3 * FP_ONE / 2;
+    aiCarry = 0;
     player2Ready = false;
 
+    // The only randomness in a game: everything after follows from the
+    // seed and the inputs
+    rng = random(1, 0x7FFFFFFF);
     resetBall(random(0, 2) == 0);
     state = State::PLAYING;
-    lastUpdate = millis();
+    lastTickAt = micros();
+    tickBacklog = 0;
 }
 
 void PongApp::resetBall(bool towardsPlayer) {
-    ballX = 64;
-    ballY = 32;
+    ballX = 64 << FP_SHIFT;
+    ballY = 32 << FP_SHIFT;
 
-    float speed = 2.0;
-    float angle = random(-45, 46) * PI / 180.0;
+    // LCG: enough to vary serves, and reproducible from the seed
+    rng = rng * 1664525 + 1013904223;
+    uint32_t r = rng >> 16;
+    const int16_t* dir = SERVE_DIRS[r % SERVE_DIR_COUNT];
 
-    ballVX = cos(angle) * speed * (towardsPlayer ? -1 : 1);
-    ballVY = sin(angle) * speed;
+    ballVX = towardsPlayer ? -dir[0] : dir[0];
+    ballVY = (r & 0x8000) ? -dir[1] : dir[1];
 }
 
 void PongApp::updateAI() {
     // Simple AI: move towards ball
-    float targetY = ballY - PADDLE_H / 2;
+    int32_t targetY = ballY - ((PADDLE_H / 2) << FP_SHIFT);
 
     // Add some prediction
     if (ballVX > 0) {
         // Ball coming towards AI
-        float timeToReach = (120 - ballX) / ballVX;
-        targetY = ballY + ballVY * timeToReach - PADDLE_H / 2;
+        int32_t ticksToReach = ((120 << FP_SHIFT) - ballX) / ballVX;
+        targetY += ballVY * ticksToReach;
     }
 
+    // Whole pixels only; the fraction carries over to the next tick
+    aiCarry += aiSpeed;
+    int step = aiCarry >> FP_SHIFT;
+    aiCarry &= FP_ONE - 1;
+
     // Move towards target
-    if (aiY < targetY - 2) {
-        aiY += aiSpeed;
-    } else if (aiY > targetY + 2) {
-        aiY -= aiSpeed;
+    int32_t y = aiY << FP_SHIFT;
+    if (y < targetY - (2 << FP_SHIFT)) {
+        aiY += step;
+    } else if (y > targetY + (2 << FP_SHIFT)) {
+        aiY -= step;
     }
 
     // Clamp to screen
@@ -174,20 +214,76 @@ void PongApp::updateAI() {
     if (aiY > 64 - PADDLE_H) aiY = 64 - PADDLE_H;
 }
 
-// WebSocket event handler (static wrapper)
-void PongApp::wsEventHandler(uint8_t num, WStype_t type, uint8_t* payload, size_t length) {
-    if (pongInstance) {
-        pongInstance->onWebSocketEvent(num, type, payload, length);
+// WebSocket event handler; runs on the web server task, so only queue
+void PongApp::wsEventHandler(AsyncWebSocket* server, AsyncWebSocketClient* client,
+                             AwsEventType type, void* arg, uint8_t* data, size_t len) {
+    switch (type) {
+        case WS_EVT_CONNECT:
+            if (!lobbyOpen) {
+                client->close();
+                return;
+            }
+            pushNetEvent(client->id(), type, 0);
+            break;
+
+        case WS_EVT_DISCONNECT:
+            pushNetEvent(client->id(), type, 0);
+            break;
+
+        case WS_EVT_PONG:
+            // Our ping payload is the millis() it was sent at
+            if (len == 4) {
+                uint32_t sentAt;
+                memcpy(&sentAt, data, 4);
+                pushNetEvent(client->id(), WS_EVT_DATA, 'P', 0, 0, millis() - sentAt);
+            }
+            break;
+
+        case WS_EVT_DATA: {
+            AwsFrameInfo* info = (AwsFrameInfo*)arg;
+            if (!info->final || info->index != 0 || info->len != len || len == 0) break;
+            if (info->opcode == WS_TEXT) {
+                pushNetEvent(client->id(), type, (char)data[0]);
+            } else if (info->opcode == WS_BINARY && len == 3 && data[0] == 'I') {
+                pushNetEvent(client->id(), type, 'I', data[1], data[2]);
+            }
+            break;
+        }
+
+        default:
+            break;
     }
 }
 
-void PongApp::onWebSocketEvent(uint8_t num, WStype_t type, uint8_t* payload, size_t length) {
+void PongApp::pollNetEvents() {
+    NetEvent ev;
+    while (popNetEvent(ev)) {
+        if (ev.cmd == 'P') {
+            if (ev.clientId == player2ClientId) {
+                // Smoothed, first sample taken as is
+                p2RttMs = p2RttMs ? (p2RttMs * 3 + ev.value) / 4 : max(ev.value, (uint32_t)1);
+            }
+            continue;
+        }
+        onWebSocketEvent(ev.clientId, ev.type, ev.cmd, ev.seq, ev.held);
+    }
+}
+
+void PongApp::onWebSocketEvent(uint32_t clientId, AwsEventType type, char cmd,
+                               uint8_t seq, uint8_t held) {
     switch (type) {
-        case WStype_DISCONNECTED:
-            if (num == player2ClientNum) {
+        case WS_EVT_DISCONNECT:
+            for (int i = 0; i < spectatorCount; i++) {
+                if (spectators[i].clientId == clientId) {
+                    spectators[i] = spectators[--spectatorCount];
+                    break;
+                }
+            }
+            if (clientId == player2ClientId) {
                 player2Connected = false;
-                player2ClientNum = -1;
+                player2ClientId = 0;
                 player2Ready = false;
+                p2Held = 0;
                 // If playing, P1 wins by forfeit
                 if (state == State::PLAYING) {
                     playerWon = true;
@@ -196,28 +292,29 @@ void PongApp::onWebSocketEvent(uint8_t num, WStype_t type, uint8_t* payload, siz
             }
             break;
 
-        case WStype_CONNECTED:
+        case WS_EVT_CONNECT:
             if (!player2Connected) {
                 player2Connected = true;
-                player2ClientNum = num;
+                player2ClientId = clientId;
                 player2Ready = false;
+                p2Held = 0;
+                p2InputSeq = 0;     // The page starts counting again
+                p2RttMs = 0;
+                p2NeedsKey = true;
+            } else if (spectatorCount < MAX_SPECTATORS) {
+                spectators[spectatorCount++] = {clientId, true};
+                pongSocket.text(clientId, "S");
             } else {
-                // Reject additional connections
-                wsServer->disconnect(num);
+                pongSocket.close(clientId);
             }
             break;
 
-        case WStype_TEXT:
-            if (num == player2ClientNum && length > 0) {
-                char cmd = (char)payload[0];
-                if (cmd == 'U') {
-                    // Move P2 paddle up
-                    aiY -= 3;
-                    if (aiY < 0) aiY = 0;
-                } else if (cmd == 'D') {
-                    // Move P2 paddle down
-                    aiY += 3;
-                    if (aiY > 64 - PADDLE_H) aiY = 64 - PADDLE_H;
+        case WS_EVT_DATA:
+            if (clientId == player2ClientId) {
+                if (cmd == 'I') {
+                    // Held buttons; the paddle moves in the physics tick
+                    p2Held = held & (HOLD_UP | HOLD_DOWN);
+                    p2InputSeq = seq;
                 } else if (cmd == 'R') {
                     // P2 ready
                     if (state == State::WAITING_P2 || state == State::GAME_OVER) {
@@ -235,150 +332,274 @@ void PongApp::onWebSocketEvent(uint8_t num, WStype_t type, uint8_t* payload, siz
     }
 }
 
-// HTTP handler for serving Player 2 HTML page
-static void handleRoot() {
-    if (httpServer) {
-        httpServer->send_P(200, "text/html", PLAYER2_HTML);
-    }
-}
-
 void PongApp::startWebSocketServer() {
-    if (wsServer) return;
+    if (lobbyOpen) return;
 
-    // Start HTTP server on port 80 for HTML page
-    httpServer = new WebServer(80);
-    httpServer->on("/", handleRoot);
-    httpServer->begin();
-
-    // Start WebSocket server on port 81
-    wsServer = new WebSocketsServer(81);
-    wsServer->begin();
-    wsServer->onEvent(wsEventHandler);
+    // Drop anything left over from a previous lobby
+    NetEvent ev;
+    while (popNetEvent(ev)) {}
 
     player2Connected = false;
-    player2ClientNum = -1;
+    player2ClientId = 0;
     player2Ready = false;
+    p2Held = 0;
+    spectatorCount = 0;
     lastP2Update = 0;
+    lobbyOpen = true;
 }
 
 void PongApp::stopWebSocketServer() {
-    if (httpServer) {
-        httpServer->stop();
-        delete httpServer;
-        httpServer = nullptr;
-    }
-    if (wsServer) {
-        wsServer->close();
-        delete wsServer;
-        wsServer = nullptr;
-    }
+    lobbyOpen = false;
+    pongSocket.closeAll();
     player2Connected = false;
-    player2ClientNum = -1;
+    player2ClientId = 0;
     player2Ready = false;
+    spectatorCount = 0;
 }
 
 void PongApp::sendGameState() {
-    if (!wsServer || !player2Connected) return;
+    if (!player2Connected && spectatorCount == 0) return;
 
     // Throttle to 30 FPS
     if (millis() - lastP2Update < 33) return;
     lastP2Update = millis();
 
-    // State code: 2=waiting, 3=playing, 4=game_over
-    int stateCode = (state == State::PLAYING) ? 3 :
-                    (state == State::GAME_OVER) ? 4 : 2;
+    unsigned long t0 = micros();
+
+    // Encoded once per tick and shared by every client. Clients that need
+    // a keyframe (new, or resyncing after a drop) share a second encoding.
+    bool keyframe = framesSinceKey >= FRAME_KEY_EVERY - 1;
+    SentFields now = snapshot();
+    uint16_t stamp = millis();
+    frameSeq++;
+    uint8_t frame[FRAME_MAX];
+    size_t len = encodeFrame(frame, now, keyframe, stamp);
+    AsyncWebSocketSharedBuffer delta = std::make_shared<std::vector<uint8_t>>(frame, frame + len);
+    AsyncWebSocketSharedBuffer key = keyframe ? delta : nullptr;
+
+    auto sendTo = [&](uint32_t clientId, bool& needsKey) {
+        AsyncWebSocketClient* c = pongSocket.client(clientId);
+        if (!c) return;
+        // Backpressure: a frame still queued is stale once the next one is
+        // due, so skip this one and resync the client with a keyframe
+        if (c->queueLen() >= MAX_QUEUED_FRAMES) {
+            needsKey = true;
+            framesDropped++;
+            return;
+        }
+        if (needsKey && !key) {
+            size_t keyLen = encodeFrame(frame, now, true, stamp);
+            key = std::make_shared<std::vector<uint8_t>>(frame, frame + keyLen);
+        }
+        const AsyncWebSocketSharedBuffer& buf = needsKey ? key : delta;
+        c->binary(buf);
+        needsKey = false;
+        framesSent++;
+        frameBytesSent += buf->size();
+    };
+
+    if (player2Connected) sendTo(player2ClientId, p2NeedsKey);
+    for (int i = 0; i < spectatorCount; i++) {
+        sendTo(spectators[i].clientId, spectators[i].needsKey);
+    }
 
-    char json[80];
-    snprintf(json, sizeof(json),
-        "{\"p1\":%d,\"p2\":%d,\"bx\":%d,\"by\":%d,\"s1\":%d,\"s2\":%d,\"st\":%d}",
-        playerY, aiY, (int)ballX, (int)ballY, playerScore, aiScore, stateCode);
+    lastSent = now;
+    framesSinceKey = keyframe ? 0 : framesSinceKey + 1;
+    Metrics::observe(sendHistogram, micros() - t0);
+}
 
-    wsServer->sendTXT(player2ClientNum, json);
+PongApp::SentFields PongApp::snapshot() {
+    SentFields now;
+    now.p1 = playerY;
+    now.p2 = aiY;
+    // Clamp: the ball is briefly off-screen when a point is scored
+    now.ballX = constrain(ballX, 0, 128 << FP_SHIFT) >> (FP_SHIFT - 4);
+    now.ballY = constrain(ballY, 0, 64 << FP_SHIFT) >> (FP_SHIFT - 4);
+    now.score = (min(playerScore, 15) << 4) | min(aiScore, 15);
+    now.state = (state == State::PLAYING) ? 1 :
+                (state == State::GAME_OVER) ? 2 : 0;
+    now.ack = p2InputSeq & ACK_MASK;
+    return now;
 }
 
-void PongApp::update() {
-    // Handle HTTP server
-    if (httpServer) {
-        httpServer->handleClient();
+// Fields that differ from lastSent, or all of them for a keyframe
+size_t PongApp::encodeFrame(uint8_t* out, const SentFields& now, bool keyframe,
+                            uint16_t stamp) {
+    uint8_t mask = 0;
+    if (keyframe || now.p1 != lastSent.p1) mask |= F_P1;
+    if (keyframe || now.p2 != lastSent.p2) mask |= F_P2;
+    if (keyframe || now.ballX != lastSent.ballX || now.ballY != lastSent.ballY) mask |= F_BALL;
+    if (keyframe || now.score != lastSent.score) mask |= F_SCORE;
+    // Keyframes repeat the ack, in case a dropped delta carried it
+    if (keyframe || now.state != lastSent.state || now.ack != lastSent.ack) mask |= F_STATE;
+
+    size_t n = 0;
+    out[n++] = (FRAME_VERSION << 6) | mask;
+    out[n++] = frameSeq;
+    out[n++] = stamp & 0xFF;
+    out[n++] = stamp >> 8;
+    if (mask & F_P1) out[n++] = now.p1;
+    if (mask & F_P2) out[n++] = now.p2;
+    if (mask & F_BALL) {
+        out[n++] = now.ballX & 0xFF;
+        out[n++] = ((now.ballX >> 8) & 0x0F) | ((now.ballY & 0x0F) << 4);
+        out[n++] = now.ballY >> 4;
     }
+    if (mask & F_SCORE) out[n++] = now.score;
+    if (mask & F_STATE) out[n++] = (now.state << 6) | now.ack;
+    return n;
+}
 
-    // Handle WebSocket server loop
-    if (wsServer) {
-        wsServer->loop();
-    }
+void PongApp::update() {
+    // Player 2 input and connects, queued by the web server task
+    pollNetEvents();
 
     // Send game state to P2 in PvP mode
     if (gameMode == GameMode::VS_PLAYER && (state == State::PLAYING || state == State::WAITING_P2 || state == State::GAME_OVER)) {
         sendGameState();
+
+        // Measure RTT with WebSocket pings; the browser answers them itself
+        if (player2Connected && millis() - lastPing >= PING_INTERVAL_MS) {
+            lastPing = millis();
+            AsyncWebSocketClient* c = pongSocket.client(player2ClientId);
+            if (c) {
+                uint32_t stamp = lastPing;
+                c->ping((const uint8_t*)&stamp, 4);
+            }
+        }
     }
 
     if (state != State::PLAYING) return;
 
-    // Frame rate control (~60 FPS)
-    if (millis() - lastUpdate < 16) return;
-    lastUpdate = millis();
+    // Fixed timestep: one tick per TICK_US of real time, however long the
+    // last render or network burst took. After a stall the backlog is
+    // capped, so the game skips ahead a little instead of fast-forwarding.
+    unsigned long now = micros();
+    tickBacklog += now - lastTickAt;
+    lastTickAt = now;
+    if (tickBacklog > TICK_US * MAX_CATCH_UP_TICKS) {
+        ticksDropped += tickBacklog / TICK_US - MAX_CATCH_UP_TICKS;
+        tickBacklog = TICK_US * MAX_CATCH_UP_TICKS;
+    }
+
+    uint8_t p1Held = (Input::isPressed(BTN_UP) ? HOLD_UP : 0) |
+                     (Input::isPressed(BTN_DOWN) ? HOLD_DOWN : 0);
+    uint8_t events = 0;
+    while (tickBacklog >= TICK_US && state == State::PLAYING) {
+        tickBacklog -= TICK_US;
+        unsigned long t0 = micros();
+        events |= stepPhysics(p1Held);
+        Metrics::observe(tickHistogram, micros() - t0);
+    }
+
+    // One sound per update, the most important one
+    if (events & EV_P2_SCORED) {
+        Audio::tone(500, 100, AUDIO_PRIO_EFFECT);
+    } else if (events & EV_P1_SCORED) {
+        Audio::tone(1000, 100, AUDIO_PRIO_EFFECT);
+    } else if (events & EV_PADDLE) {
+        Audio::tone(2000, 30, AUDIO_PRIO_EFFECT);
+    } else if (events & EV_WALL) {
+        Audio::tone(1500, 20, AUDIO_PRIO_EFFECT);
+    }
+}
+
+// One 60 Hz tick. Reads nothing but the game state and the held buttons,
+// so a game replays exactly from its seed and inputs.
+uint8_t PongApp::stepPhysics(uint8_t p1Held) {
+    uint8_t events = 0;
 
     // Player input
-    if (Input::isPressed(BTN_UP)) {
-        playerY -= 3;
+    if (p1Held & HOLD_UP) {
+        playerY -= PADDLE_STEP;
         if (playerY < 0) playerY = 0;
     }
-    if (Input::isPressed(BTN_DOWN)) {
-        playerY += 3;
+    if (p1Held & HOLD_DOWN) {
+        playerY += PADDLE_STEP;
         if (playerY > 64 - PADDLE_H) playerY = 64 - PADDLE_H;
     }
 
+    // P2 moves from its held buttons at the same rate as P1
+    if (gameMode == GameMode::VS_PLAYER) {
+        if (p2Held & HOLD_UP) {
+            aiY -= PADDLE_STEP;
+            if (aiY < 0) aiY = 0;
+        }
+        if (p2Held & HOLD_DOWN) {
+            aiY += PADDLE_STEP;
+            if (aiY > 64 - PADDLE_H) aiY = 64 - PADDLE_H;
+        }
+    }
+
     // Update AI (only in VS_AI mode)
     if (gameMode == GameMode::VS_AI) {
         updateAI();
     }
 
     // Move ball
+    int32_t x0 = ballX;
+    int32_t y0 = ballY;
     ballX += ballVX;
     ballY += ballVY;
 
-    // Top/bottom wall bounce
-    if (ballY <= 0 || ballY >= 64 - BALL_SIZE) {
-        ballVY = -ballVY;
-        ballY = constrain(ballY, 0, 64 - BALL_SIZE);
-        UI::beep(1500, 20);
-    }
-
-    // Player paddle collision (left side)
-    if (ballX <= PADDLE_W + 4 && ballX >= 4) {
-        if (ballY + BALL_SIZE >= playerY && ballY <= playerY + PADDLE_H) {
-            ballVX = abs(ballVX) * 1.05;  // Speed up slightly
-            ballVY += (ballY - (playerY + PADDLE_H / 2)) * 0.1;
-            ballX = PADDLE_W + 5;
-            UI::beep(2000, 30);
+    // Paddles, swept: check where the ball crossed the paddle face during
+    // the tick, not where it ended up, so a fast ball can't skip past it.
+    // The part of the move beyond the face is reflected back.
+    const int32_t leftFace = (4 + PADDLE_W) << FP_SHIFT;
+    const int32_t rightFace = (128 - 4 - PADDLE_W - BALL_SIZE) << FP_SHIFT;
+    int paddleY = -1;
+    int32_t hitY = 0;
+    if (ballVX < 0 && x0 >= leftFace && ballX < leftFace) {
+        hitY = crossingY(leftFace, x0, y0);
+        if (hitY + (BALL_SIZE << FP_SHIFT) >= (playerY << FP_SHIFT) &&
+            hitY <= (playerY + PADDLE_H) << FP_SHIFT) {
+            paddleY = playerY;
+            ballX = 2 * leftFace - ballX;
         }
+    } else if (ballVX > 0 && x0 <= rightFace && ballX > rightFace) {
+        hitY = crossingY(rightFace, x0, y0);
+        if (hitY + (BALL_SIZE << FP_SHIFT) >= (aiY << FP_SHIFT) &&
+            hitY <= (aiY + PADDLE_H) << FP_SHIFT) {
+            paddleY = aiY;
+            ballX = 2 * rightFace - ballX;
+        }
+    }
+    if (paddleY >= 0) {
+        // Speed up ~5% per hit, and angle off the paddle's centre
+        int32_t vx = min(abs(ballVX) * 269 / 256, BALL_MAX_VX);
+        ballVX = ballVX < 0 ? vx : -vx;
+        ballVY += ((hitY - ((paddleY + PADDLE_H / 2) << FP_SHIFT)) * 26) >> FP_SHIFT;
+        ballVY = constrain(ballVY, -BALL_MAX_VY, BALL_MAX_VY);
+        events |= EV_PADDLE;
     }
 
-    // AI/P2 paddle collision (right side)
-    if (ballX >= 128 - PADDLE_W - 4 - BALL_SIZE && ballX <= 128 - 4 - BALL_SIZE) {
-        if (ballY + BALL_SIZE >= aiY && ballY <= aiY + PADDLE_H) {
-            ballVX = -abs(ballVX) * 1.05;
-            ballVY += (ballY - (aiY + PADDLE_H / 2)) * 0.1;
-            ballX = 128 - PADDLE_W - 5 - BALL_SIZE;
-            UI::beep(2000, 30);
-        }
+    // Top/bottom wall bounce, reflecting the overshoot
+    const int32_t bottom = (64 - BALL_SIZE) << FP_SHIFT;
+    if (ballY < 0) {
+        ballY = -ballY;
+        ballVY = -ballVY;
+        events |= EV_WALL;
+    } else if (ballY > bottom) {
+        ballY = 2 * bottom - ballY;
+        ballVY = -ballVY;
+        events |= EV_WALL;
     }
 
     // Scoring
     if (ballX < 0) {
         // AI/P2 scores
         aiScore++;
-        UI::beep(500, 100);
+        events |= EV_P2_SCORED;
         if (aiScore >= winScore) {
             playerWon = false;
             state = State::GAME_OVER;
         } else {
             resetBall(true);
         }
-    } else if (ballX > 128) {
+    } else if (ballX > 128 << FP_SHIFT) {
         // Player scores
         playerScore++;
-        UI::beep(1000, 100);
+        events |= EV_P1_SCORED;
         if (playerScore >= winScore) {
             playerWon = true;
             state = State::GAME_OVER;
@@ -389,8 +610,16 @@ void PongApp::update() {
 
     // Increase AI speed as game progresses (only in AI mode)
     if (gameMode == GameMode::VS_AI) {
-        aiSpeed = 1.5 + (playerScore + aiScore) * 0.1;
+        aiSpeed = 3 * FP_ONE / 2 + (playerScore + aiScore) * 26;
     }
+
+    return events;
+}
+
+// Ball y at the moment its leading edge reached faceX during the last tick
+int32_t PongApp::crossingY(int32_t faceX, int32_t x0, int32_t y0) {
+    int32_t t = ((faceX - x0) << FP_SHIFT) / ballVX;   // 0..FP_ONE of the tick
+    return y0 + ((ballVY * t) >> FP_SHIFT);
 }
 
 void PongApp::render() {
@@ -427,12 +656,16 @@ void PongApp::render() {
             {
                 IPAddress ip = WiFiManager::getIP();
                 char ipStr[24];
-                snprintf(ipStr, sizeof(ipStr), "%d.%d.%d.%d",
+                snprintf(ipStr, sizeof(ipStr), "%d.%d.%d.%d/pong",
                     ip[0], ip[1], ip[2], ip[3]);
                 UI::drawCentered(24, "Open in browser:");
                 UI::drawCentered(36, ipStr);
 
-                if (player2Connected) {
+                if (player2Connected && p2RttMs > 0) {
+                    char rtt[24];
+                    snprintf(rtt, sizeof(rtt), "P2 joined RTT %lums", (unsigned long)p2RttMs);
+                    UI::drawCentered(50, rtt);
+                } else if (player2Connected) {
                     UI::drawCentered(50, "P2 Connected!");
                 } else {
                     // Animated waiting dots
@@ -467,7 +700,7 @@ void PongApp::render() {
             u8g2.drawBox(128 - 4 - PADDLE_W, aiY, PADDLE_W, PADDLE_H);
 
             // Ball
-            u8g2.drawBox((int)ballX, (int)ballY, BALL_SIZE, BALL_SIZE);
+            u8g2.drawBox(ballX >> FP_SHIFT, ballY >> FP_SHIFT, BALL_SIZE, BALL_SIZE);
             break;
 
         case State::GAME_OVER:
@@ -2,61 +2,97 @@
 #include "ui.h"
 #include "wifi_manager.h"
 #include "icons.h"
+#include "data_store.h"
 #include <ArduinoJson.h>
 
 void QuotesApp::init() {
     hasData = false;
     loading = false;
+    stale = false;
     errorMsg[0] = '\0';
-}
 
-void QuotesApp::update() {
-    // No auto-refresh
+    // Show the last quote until a new one is requested
+    QuoteItem item;
+    if (DataStore::load("quotes", &item, sizeof(item))) {
+        strcpy(quote, item.quote);
+        strcpy(author, item.author);
+        hasData = true;
+        stale = true;
+    }
 }
 
-void QuotesApp::fetchQuote() {
-    if (!WiFiManager::isConnected()) {
-        strcpy(errorMsg, "No WiFi");
-        return;
+void QuotesApp::update() {
+    // Top up the prefetch queue while the current quote is on screen
+    if (WiFiManager::canFetch() && queue.wantsRefill()) {
+        queue.refill();
     }
+}
 
-    loading = true;
+int QuotesApp::fillQueue(PrefetchQueue<QuoteItem, PREFETCH_DEPTH>& q, int wanted) {
+    // Quotable API: batch of random quotes in one request
+    char url[96];
+    snprintf(url, sizeof(url), "https://api.quotable.io/quotes/random?limit=%d&maxLength=150", wanted);
 
-    // Quotable API
-    String response = WiFiManager::httpGet("https://api.quotable.io/random?maxLength=150");
-    loading = false;
+    String response = WiFiManager::httpGet(url);
+    if (response.length() == 0) return 0;
 
-    if (response.length() == 0) {
-        strcpy(errorMsg, "Network error");
-        return;
+    DynamicJsonDocument doc(512 * PREFETCH_DEPTH);
+    DeserializationError error = deserializeJson(doc, response);
+    if (error) return 0;
+
+    int added = 0;
+    for (JsonObject obj : doc.as<JsonArray>()) {
+        QuoteItem* slot = q.nextFree();
+        if (!slot) break;
+
+        const char* content = obj["content"] | "";
+        const char* auth = obj["author"] | "Unknown";
+        if (strlen(content) == 0) continue;
+
+        strncpy(slot->quote, content, sizeof(slot->quote) - 1);
+        slot->quote[sizeof(slot->quote) - 1] = '\0';
+        strncpy(slot->author, auth, sizeof(slot->author) - 1);
+        slot->author[sizeof(slot->author) - 1] = '\0';
+        q.commit();
+        added++;
     }
 
-    // Parse JSON
-    StaticJsonDocument<512> doc;
-    DeserializationError error = deserializeJson(doc, response);
+    return added;
+}
 
-    if (error) {
-        strcpy(errorMsg, "Parse error");
-        return;
+void QuotesApp::fetchQuote() {
+    if (queue.isEmpty()) {
+        if (!WiFiManager::canFetch()) {
+            strcpy(errorMsg, "No WiFi");
+            return;
+        }
+
+        // Nothing prefetched yet - fetch in the foreground
+        loading = true;
+        queue.refill();
+        loading = false;
+
+        if (queue.isEmpty()) {
+            strcpy(errorMsg, "Network error");
+            return;
+        }
     }
 
-    const char* content = doc["content"] | "";
-    const char* auth = doc["author"] | "Unknown";
-
-    strncpy(quote, content, sizeof(quote) - 1);
-    strncpy(author, auth, sizeof(author) - 1);
+    QuoteItem item;
+    queue.pop(item);
+    DataStore::save("quotes", &item, sizeof(item));
+    strcpy(quote, item.quote);
+    strcpy(author, item.author);
 
-    hasData = strlen(quote) > 0;
-    if (!hasData) {
-        strcpy(errorMsg, "No quote received");
-    } else {
-        errorMsg[0] = '\0';
-    }
+    hasData = true;
+    stale = false;
+    errorMsg[0] = '\0';
 }
 
 void QuotesApp::render() {
     UI::clear();
     UI::drawTitleBar("Quotes");
+    if (stale) UI::drawStaleTag();
 
     if (loading) {
         UI::drawCentered(35, "Loading...");
@@ -45,17 +45,56 @@ void SettingsApp::saveSettings() {
     prefs.end();
 }
 
+void SettingsApp::trackWifiSelection() {
+    // Scan results re-sort as channels come in; keep the cursor on the
+    // same network rather than the same row
+    int count = WiFiManager::getScanCount();
+    WiFiNetwork* networks = WiFiManager::getScanResults();
+
+    if (WiFiManager::getScanVersion() != wifiScanVersion) {
+        wifiScanVersion = WiFiManager::getScanVersion();
+        for (int i = 0; i < count; i++) {
+            if (strcmp(networks[i].ssid, wifiHighlight) == 0) {
+                wifiIndex = i;
+                break;
+            }
+        }
+    }
+
+    if (wifiIndex >= count) wifiIndex = max(0, count - 1);
+    if (count > 0) {
+        strncpy(wifiHighlight, networks[wifiIndex].ssid, sizeof(wifiHighlight) - 1);
+    }
+}
+
+void SettingsApp::startConnect(const char* password) {
+    WiFiManager::connectAsync(selectedSSID, password);
+    lastConnectPhase = ConnectPhase::WAITING;
+    connectFinished = false;
+    mode = Mode::WIFI_CONNECTING;
+}
+
 void SettingsApp::update() {
-    if (mode == Mode::WIFI_PASSWORD && Keyboard::isConfirmed()) {
-        // Connect with password
-        const char* password = Keyboard::getText();
-        if (WiFiManager::connect(selectedSSID, password)) {
-            WiFiManager::saveNetwork(selectedSSID, password);
+    if (mode == Mode::WIFI_LIST) {
+        trackWifiSelection();
+    }
+
+    if (mode == Mode::WIFI_CONNECTING && !connectFinished) {
+        // lastConnectPhase keeps the step that was running when it failed
+        ConnectPhase phase = WiFiManager::getConnectPhase();
+        if (phase == ConnectPhase::DONE) {
             UI::beep(1000, 100);
-        } else {
+            connectFinished = true;
+        } else if (phase == ConnectPhase::FAILED) {
             UI::beep(500, 200);
+            connectFinished = true;
+        } else {
+            lastConnectPhase = phase;
         }
-        mode = Mode::MENU;
+    }
+
+    if (mode == Mode::WIFI_PASSWORD && Keyboard::isConfirmed()) {
+        startConnect(Keyboard::getText());
     } else if (mode == Mode::WIFI_PASSWORD && Keyboard::isCancelled()) {
         mode = Mode::WIFI_LIST;
     } else if (mode == Mode::EDIT_API_KEY && Keyboard::isConfirmed()) {
@@ -89,10 +128,34 @@ void SettingsApp::render() {
             renderMenu();
             break;
         case Mode::WIFI_LIST:
-        case Mode::WIFI_SCAN:
+        case Mode::WIFI_SCAN: {
             renderWifiList();
-            statusLeft = "A:Connect C:Scan";
+            static char scanStatus[24];
+            unsigned long age = WiFiManager::getScanAge();
+            if (WiFiManager::isScanning()) {
+                snprintf(scanStatus, sizeof(scanStatus), "Scanning %d/%d",
+                         WiFiManager::getScanChannel(), WIFI_SCAN_CHANNELS);
+            } else if (age < 1000000UL) {
+                snprintf(scanStatus, sizeof(scanStatus), "A:Join C:Scan %lus", age / 1000);
+            } else {
+                snprintf(scanStatus, sizeof(scanStatus), "A:Connect C:Scan");
+            }
+            statusLeft = scanStatus;
+            break;
+        }
+        case Mode::WIFI_CONNECTING: {
+            renderConnecting();
+            ConnectPhase phase = WiFiManager::getConnectPhase();
+            if (phase == ConnectPhase::DONE) {
+                statusLeft = WiFiManager::hasInternet() ? "A:OK Online" : "A:OK No internet";
+            } else if (phase == ConnectPhase::FAILED) {
+                statusLeft = WiFiManager::getConnectError();
+            } else {
+                statusLeft = "Connecting...";
+                statusRight = "B:Cancel";
+            }
             break;
+        }
         case Mode::API_KEYS:
             renderApiKeys();
             statusLeft = "A:Edit";
@@ -140,14 +203,14 @@ void SettingsApp::renderMenu() {
 }
 
 void SettingsApp::renderWifiList() {
-    if (scanning) {
+    int count = WiFiManager::getScanCount();
+    WiFiNetwork* networks = WiFiManager::getScanResults();
+
+    if (count == 0 && WiFiManager::isScanning()) {
         UI::drawCentered(35, "Scanning...");
         return;
     }
 
-    int count = WiFiManager::getScanCount();
-    WiFiNetwork* networks = WiFiManager::getScanResults();
-
     if (count == 0) {
         UI::drawCentered(35, "No networks found");
         UI::drawCentered(48, "Press C to scan");
@@ -168,6 +231,42 @@ void SettingsApp::renderWifiList() {
     }
 }
 
+void SettingsApp::renderConnecting() {
+    static const char* steps[] = {"Join network", "Get IP (DHCP)", "Check internet"};
+    static const ConnectPhase stepPhases[] = {
+        ConnectPhase::JOINING, ConnectPhase::DHCP, ConnectPhase::INTERNET_CHECK
+    };
+
+    ConnectPhase phase = WiFiManager::getConnectPhase();
+    bool done = (phase == ConnectPhase::DONE);
+    bool failed = (phase == ConnectPhase::FAILED);
+
+    UI::setSmallFont();
+    char line[40];
+    snprintf(line, sizeof(line), "Network: %s", selectedSSID);
+    u8g2.drawStr(4, 22, line);
+
+    // "*" done, ">" running (blinks), "x" failed, "-" not reached yet
+    bool blink = (millis() / 400) % 2;
+    bool reached = true;
+    for (int i = 0; i < 3; i++) {
+        const char* mark;
+        if (done) {
+            mark = "*";
+        } else if (stepPhases[i] == lastConnectPhase) {
+            mark = failed ? "x" : (blink ? ">" : " ");
+            reached = false;
+        } else {
+            mark = reached ? "*" : "-";
+        }
+        if (!done && lastConnectPhase == ConnectPhase::WAITING) mark = "-";
+
+        snprintf(line, sizeof(line), "%s %s", mark, steps[i]);
+        u8g2.drawStr(8, 32 + i * 9, line);
+    }
+    UI::setNormalFont();
+}
+
 void SettingsApp::renderApiKeys() {
     const char* items[] = {"Weather API Key", "News API Key"};
 
@@ -268,7 +367,8 @@ void SettingsApp::onButton(uint8_t btn, bool pressed) {
                 if (menuIndex == 0) {
                     mode = Mode::WIFI_LIST;
                     wifiIndex = 0;
-                    WiFiManager::scan();
+                    wifiHighlight[0] = '\0';
+                    WiFiManager::startScan();  // Reuses a recent scan
                 } else if (menuIndex == 1) {
                     mode = Mode::API_KEYS;
                     apiKeyIndex = 0;
@@ -290,33 +390,42 @@ void SettingsApp::onButton(uint8_t btn, bool pressed) {
             break;
 
         case Mode::WIFI_LIST:
-            if (btn == BTN_UP && wifiIndex > 0) wifiIndex--;
-            else if (btn == BTN_DOWN && wifiIndex < WiFiManager::getScanCount() - 1) wifiIndex++;
-            else if (btn == BTN_A && WiFiManager::getScanCount() > 0) {
+            if (btn == BTN_UP && wifiIndex > 0) {
+                wifiIndex--;
+                trackWifiSelection();
+            } else if (btn == BTN_DOWN && wifiIndex < WiFiManager::getScanCount() - 1) {
+                wifiIndex++;
+                trackWifiSelection();
+            } else if (btn == BTN_A && WiFiManager::getScanCount() > 0) {
                 WiFiNetwork* networks = WiFiManager::getScanResults();
                 strncpy(selectedSSID, networks[wifiIndex].ssid, sizeof(selectedSSID) - 1);
 
                 if (networks[wifiIndex].open) {
                     // Open network, connect directly
-                    if (WiFiManager::connect(selectedSSID, "")) {
-                        WiFiManager::saveNetwork(selectedSSID, "");
-                        UI::beep(1000, 100);
-                    }
-                    mode = Mode::MENU;
+                    startConnect("");
                 } else {
                     // Need password
                     mode = Mode::WIFI_PASSWORD;
                     Keyboard::show("Password:", keyboardBuffer, sizeof(keyboardBuffer));
                 }
             } else if (btn == BTN_C) {
-                scanning = true;
-                WiFiManager::scan();
-                scanning = false;
+                WiFiManager::startScan(true);
             } else if (btn == BTN_B) {
                 mode = Mode::MENU;
             }
             break;
 
+        case Mode::WIFI_CONNECTING:
+            if (!connectFinished) {
+                if (btn == BTN_B) {
+                    WiFiManager::cancelConnect();
+                    mode = Mode::WIFI_LIST;
+                }
+            } else if (btn == BTN_A || btn == BTN_B) {
+                mode = (WiFiManager::getConnectPhase() == ConnectPhase::DONE) ? Mode::MENU : Mode::WIFI_LIST;
+            }
+            break;
+
         case Mode::API_KEYS:
             if (btn == BTN_UP && apiKeyIndex > 0) apiKeyIndex--;
             else if (btn == BTN_DOWN && apiKeyIndex < 1) apiKeyIndex++;
@@ -1,10 +1,51 @@
 #include "apps/snake.h"
 #include "ui.h"
 #include "icons.h"
+#include "input.h"
+#include "audio.h"
 #include <Preferences.h>
 
+// NVS blob "snake_run": version, seed (4), moves (2), turns (2), then the
+// packed turns
+static const uint8_t REPLAY_BLOB_VERSION = 1;
+static const size_t REPLAY_HEADER = 9;
+
+static const int TURN_BITS = 6;
+static const int TURN_MAX_GAP = 32;
+
+// Menu entries; the last two need a saved run
+static const char* const MENU_ITEMS[] = {"Play", "Autoplay", "Race best run", "Watch best run"};
+static const int MENU_PLAY = 0;
+static const int MENU_AUTOPLAY = 1;
+static const int MENU_RACE = 2;
+static const int MENU_WATCH = 3;
+
+static unsigned long average(uint32_t total, uint32_t count) {
+    return count ? total / count : 0;
+}
+
+// Bits are packed LSB first, so a value may straddle two bytes
+static void putBits(uint8_t* buf, int pos, int count, uint32_t value) {
+    for (int i = 0; i < count; i++, pos++) {
+        if (value & (1UL << i)) {
+            buf[pos >> 3] |= 1 << (pos & 7);
+        } else {
+            buf[pos >> 3] &= ~(1 << (pos & 7));
+        }
+    }
+}
+
+static uint32_t getBits(const uint8_t* buf, int pos, int count) {
+    uint32_t value = 0;
+    for (int i = 0; i < count; i++, pos++) {
+        if (buf[pos >> 3] & (1 << (pos & 7))) value |= 1UL << i;
+    }
+    return value;
+}
+
 void SnakeApp::init() {
     state = State::MENU;
+    menuIndex = 0;
     loadHighScore();
 }
 
@@ -12,197 +53,343 @@ void SnakeApp::loadHighScore() {
     Preferences prefs;
     prefs.begin(NVS_NAMESPACE, true);
     highScore = prefs.getInt("snake_high", 0);
+
+    static uint8_t buf[REPLAY_HEADER + sizeof(best.bits)];
+    size_t len = prefs.getBytesLength("snake_run");
+    if (len >= REPLAY_HEADER && len <= sizeof(buf)) {
+        len = prefs.getBytes("snake_run", buf, len);
+    } else {
+        len = 0;
+    }
     prefs.end();
+
+    hasBest = false;
+    if (len < REPLAY_HEADER || buf[0] != REPLAY_BLOB_VERSION) return;
+
+    memcpy(&best.seed, buf + 1, 4);
+    memcpy(&best.moves, buf + 5, 2);
+    memcpy(&best.turns, buf + 7, 2);
+    size_t bytes = (best.turns * TURN_BITS + 7) / 8;
+    if (best.turns > SNAKE_REPLAY_MAX_TURNS || REPLAY_HEADER + bytes != len) return;
+    memcpy(best.bits, buf + REPLAY_HEADER, bytes);
+    best.complete = true;
+    hasBest = true;
 }
 
 void SnakeApp::saveHighScore() {
-    if (score > highScore) {
-        highScore = score;
-        Preferences prefs;
-        prefs.begin(NVS_NAMESPACE, false);
-        prefs.putInt("snake_high", highScore);
-        prefs.end();
+    if (game.score <= highScore) return;
+    highScore = game.score;
+
+    Preferences prefs;
+    prefs.begin(NVS_NAMESPACE, false);
+    prefs.putInt("snake_high", highScore);
+
+    if (run.complete) {
+        static uint8_t buf[REPLAY_HEADER + sizeof(run.bits)];
+        size_t bytes = (run.turns * TURN_BITS + 7) / 8;
+        buf[0] = REPLAY_BLOB_VERSION;
+        memcpy(buf + 1, &run.seed, 4);
+        memcpy(buf + 5, &run.moves, 2);
+        memcpy(buf + 7, &run.turns, 2);
+        memcpy(buf + REPLAY_HEADER, run.bits, bytes);
+        prefs.putBytes("snake_run", buf, REPLAY_HEADER + bytes);
+        best = run;
+        hasBest = true;
+    } else {
+        // The old run no longer matches the high score
+        prefs.remove("snake_run");
+        hasBest = false;
     }
+    prefs.end();
 }
 
-void SnakeApp::startGame() {
-    // Initialize snake in center
-    snakeLen = 3;
-    snakeHead = 0;
-
-    int startX = SNAKE_GRID_W / 2;
-    int startY = SNAKE_GRID_H / 2;
+void SnakeApp::Replay::start(uint32_t s) {
+    seed = s;
+    moves = 0;
+    turns = 0;
+    lastTurnAt = 0;
+    complete = true;
+}
 
-    for (int i = 0; i < snakeLen; i++) {
-        snakeX[i] = startX - i;
-        snakeY[i] = startY;
+void SnakeApp::Replay::record(uint16_t move, bool clockwise) {
+    int gap = move - lastTurnAt;
+    if (!complete || gap < 1 || gap > TURN_MAX_GAP || turns >= SNAKE_REPLAY_MAX_TURNS) {
+        complete = false;
+        return;
     }
-
-    direction = 0;  // Moving right
-    nextDirection = 0;
-    score = 0;
-    speed = 150;
-    lastMove = millis();
-
-    spawnFood();
-    state = State::PLAYING;
+    putBits(bits, turns * TURN_BITS, TURN_BITS, (gap - 1) << 1 | (clockwise ? 1 : 0));
+    turns++;
+    lastTurnAt = move;
 }
 
-void SnakeApp::spawnFood() {
-    // Find empty spot
-    bool valid = false;
-    while (!valid) {
-        foodX = random(0, SNAKE_GRID_W);
-        foodY = random(0, SNAKE_GRID_H);
+void SnakeApp::rewind(ReplayCursor& cursor) {
+    cursor.turn = 0;
+    cursor.nextTurnAt = best.turns ? getBits(best.bits, 0, TURN_BITS) / 2 + 1 : 0;
+}
 
-        valid = true;
-        for (int i = 0; i < snakeLen; i++) {
-            int idx = (snakeHead - i + SNAKE_MAX_LEN) % SNAKE_MAX_LEN;
-            if (snakeX[idx] == foodX && snakeY[idx] == foodY) {
-                valid = false;
-                break;
-            }
+// Direction for g's next step, as taken in the best run
+int SnakeApp::replayDirection(const SnakeGame& g, ReplayCursor& cursor) {
+    int dir = g.direction;
+    if (cursor.turn < best.turns && g.moves + 1 == cursor.nextTurnAt) {
+        uint32_t entry = getBits(best.bits, cursor.turn * TURN_BITS, TURN_BITS);
+        dir = (dir + ((entry & 1) ? 1 : 3)) % 4;
+        cursor.turn++;
+        if (cursor.turn < best.turns) {
+            entry = getBits(best.bits, cursor.turn * TURN_BITS, TURN_BITS);
+            cursor.nextTurnAt += (entry >> 1) + 1;
         }
     }
+    return dir;
 }
 
-bool SnakeApp::checkCollision(int x, int y) {
-    // Wall collision
-    if (x < 0 || x >= SNAKE_GRID_W || y < 0 || y >= SNAKE_GRID_H) {
-        return true;
+void SnakeApp::startGame(bool withGhost) {
+    // The only randomness in a game: food follows from the seed
+    uint32_t seed = random(1, 0x7FFFFFFF);
+    game.reset(seed);
+    run.start(seed);
+    nextDirection = game.direction;
+    autoplay = false;
+
+    racingGhost = withGhost && hasBest;
+    if (racingGhost) {
+        ghost.reset(best.seed);
+        rewind(ghostCursor);
     }
 
-    // Self collision (skip head)
-    for (int i = 1; i < snakeLen; i++) {
-        int idx = (snakeHead - i + SNAKE_MAX_LEN) % SNAKE_MAX_LEN;
-        if (snakeX[idx] == x && snakeY[idx] == y) {
-            return true;
-        }
-    }
+    lastMove = millis();
+    state = State::PLAYING;
+}
 
-    return false;
+void SnakeApp::startPlayback() {
+    game.reset(best.seed);
+    rewind(playbackCursor);
+    racingGhost = false;
+    autoplay = false;
+    lastMove = millis();
+    state = State::REPLAY;
+}
+
+void SnakeApp::startAutoplay() {
+    game.reset(random(1, 0x7FFFFFFF));
+    racingGhost = false;
+    autoplay = true;
+    memset(&stats, 0, sizeof(stats));
+    stats.startedAt = millis();
+    frameDueAt = micros() + SNAKE_AUTOPLAY_FRAME_US;
+    wantsFullSpeed = true;
+    state = State::AUTOPLAY;
+}
+
+void SnakeApp::finishAutoplay() {
+    stats.elapsedMs = max(millis() - stats.startedAt, 1UL);
+    wantsFullSpeed = false;
+    state = State::GAME_OVER;
+    Serial.printf("Snake autoplay: len %d %s, %lu moves, %lu frames in %lu ms\n",
+                  game.snakeLen, game.boardFull ? "full" : "died",
+                  (unsigned long)stats.moves, (unsigned long)stats.frames, stats.elapsedMs);
+    Serial.printf("  %lu moves/s, %lu fps; per move plan %lu us, step %lu us; "
+                  "per frame draw %lu us, flush %lu us\n",
+                  stats.moves * 1000UL / stats.elapsedMs, stats.frames * 1000UL / stats.elapsedMs,
+                  average(stats.planUs, stats.moves),
+                  average(stats.stepUs, stats.moves),
+                  average(stats.drawUs, stats.frames),
+                  average(stats.flushUs, stats.frames));
 }
 
-void SnakeApp::moveSnake() {
-    // Apply direction change
-    direction = nextDirection;
+void SnakeApp::endGame() {
+    run.moves = game.moves;
+    state = State::GAME_OVER;
+    saveHighScore();
+}
 
-    // Calculate new head position
-    int headX = snakeX[snakeHead];
-    int headY = snakeY[snakeHead];
+// Speeds up slightly with each food eaten
+int SnakeApp::stepInterval() {
+    return max(80, 150 - 2 * game.score);   // ms per move
+}
 
-    switch (direction) {
-        case 0: headX++; break;  // Right
-        case 1: headY++; break;  // Down
-        case 2: headX--; break;  // Left
-        case 3: headY--; break;  // Up
+void SnakeApp::update() {
+    if (state == State::AUTOPLAY) {
+        // No step timer: moves until the next frame is due, at least one
+        // per pass
+        Input::resetActivity();
+        do {
+            unsigned long t0 = micros();
+            int dir = game.planMove();
+            unsigned long t1 = micros();
+            uint8_t result = game.step(dir);
+            stats.planUs += t1 - t0;
+            stats.stepUs += micros() - t1;
+            stats.moves++;
+            if (result & (SnakeGame::STEP_DIED | SnakeGame::STEP_FULL)) {
+                finishAutoplay();
+                break;
+            }
+        } while ((long)(micros() - frameDueAt) < 0);
+        return;
     }
 
-    // Check collision
-    if (checkCollision(headX, headY)) {
-        state = State::GAME_OVER;
-        saveHighScore();
-        UI::beep(300, 300);
+    if (state == State::REPLAY) {
+        if (millis() - lastMove < (unsigned long)stepInterval() / SNAKE_PLAYBACK_SPEEDUP) return;
+        lastMove = millis();
+
+        if (!game.alive || game.moves >= best.moves) {
+            state = State::MENU;
+            return;
+        }
+        game.step(replayDirection(game, playbackCursor));
         return;
     }
 
-    // Check food
-    bool ateFood = (headX == foodX && headY == foodY);
+    if (state != State::PLAYING) return;
 
-    if (ateFood) {
-        score++;
-        if (snakeLen < SNAKE_MAX_LEN) {
-            snakeLen++;
+    if (millis() - lastMove >= (unsigned long)stepInterval()) {
+        lastMove = millis();
+
+        if (nextDirection != game.direction) {
+            run.record(game.moves + 1, nextDirection == (game.direction + 1) % 4);
         }
-        // Speed up slightly
-        if (speed > 80) speed -= 2;
+        uint8_t result = game.step(nextDirection);
 
-        UI::beep(1500, 50);
-        spawnFood();
-    }
+        // The ghost takes its step from the best run; it stops where that
+        // run stopped
+        if (racingGhost && ghost.alive && ghost.moves < best.moves) {
+            ghost.step(replayDirection(ghost, ghostCursor));
+        }
 
-    // Move head
-    snakeHead = (snakeHead + 1) % SNAKE_MAX_LEN;
-    snakeX[snakeHead] = headX;
-    snakeY[snakeHead] = headY;
+        if (result & SnakeGame::STEP_DIED) {
+            Audio::tone(300, 300, AUDIO_PRIO_EFFECT);
+            endGame();
+        } else if (result & SnakeGame::STEP_FULL) {
+            Audio::tone(1500, 50, AUDIO_PRIO_EFFECT);
+            endGame();
+        } else if (result & SnakeGame::STEP_ATE) {
+            Audio::tone(1500, 50, AUDIO_PRIO_EFFECT);
+        }
+    }
 }
 
-void SnakeApp::update() {
-    if (state != State::PLAYING) return;
+void SnakeApp::drawGame(const SnakeGame& g, bool asGhost) {
+    for (int i = 0; i < g.snakeLen; i++) {
+        int idx = (g.snakeHead - i + SNAKE_MAX_LEN) % SNAKE_MAX_LEN;
+        int x = g.snakeX[idx] * 4;
+        int y = g.snakeY[idx] * 4;
+
+        if (asGhost) {
+            // Outline head, dotted body
+            if (i == 0) {
+                u8g2.drawFrame(x, y, 4, 4);
+            } else if (i % 2 == 0) {
+                u8g2.drawPixel(x + 1, y + 1);
+            }
+        } else if (i == 0) {
+            // Head - filled
+            u8g2.drawBox(x, y, 4, 4);
+        } else {
+            // Body
+            u8g2.drawBox(x + 1, y + 1, 2, 2);
+        }
+    }
 
-    if (millis() - lastMove >= (unsigned long)speed) {
-        moveSnake();
-        lastMove = millis();
+    if (!asGhost) {
+        // Draw food
+        u8g2.drawBox(g.foodX * 4, g.foodY * 4, 4, 4);
     }
 }
 
 void SnakeApp::render() {
+    unsigned long t0 = micros();
     UI::clear();
 
     switch (state) {
         case State::MENU:
-            UI::drawTitleBar("Snake");
-            UI::drawCentered(28, "Press A to start");
-
             {
                 char buf[32];
-                snprintf(buf, sizeof(buf), "High Score: %d", highScore);
-                UI::drawCentered(42, buf);
+                snprintf(buf, sizeof(buf), "Snake  Best: %d", highScore);
+                UI::drawTitleBar(buf);
+
+                int count = hasBest ? 4 : 2;
+                for (int i = 0; i < count; i++) {
+                    UI::drawMenuItem(21 + i * 10, MENU_ITEMS[i], i == menuIndex);
+                }
             }
 
             UI::drawStatusBar("A:Start", "B:Exit");
             break;
 
         case State::PLAYING:
+        case State::REPLAY:
+        case State::AUTOPLAY:
             {
                 // Draw border
                 u8g2.drawFrame(0, 0, SNAKE_GRID_W * 4, SNAKE_GRID_H * 4);
 
-                // Draw snake
-                for (int i = 0; i < snakeLen; i++) {
-                    int idx = (snakeHead - i + SNAKE_MAX_LEN) % SNAKE_MAX_LEN;
-                    int x = snakeX[idx] * 4;
-                    int y = snakeY[idx] * 4;
-
-                    if (i == 0) {
-                        // Head - filled
-                        u8g2.drawBox(x, y, 4, 4);
-                    } else {
-                        // Body
-                        u8g2.drawBox(x + 1, y + 1, 2, 2);
-                    }
+                if (racingGhost && ghost.alive) {
+                    drawGame(ghost, true);
                 }
-
-                // Draw food
-                u8g2.drawBox(foodX * 4, foodY * 4, 4, 4);
+                drawGame(game, false);
 
                 // Score
                 char buf[16];
-                snprintf(buf, sizeof(buf), "%d", score);
+                snprintf(buf, sizeof(buf), "%d", game.score);
                 u8g2.drawStr(SNAKE_GRID_W * 4 + 4, 10, buf);
             }
             break;
 
         case State::GAME_OVER:
+            if (autoplay) {
+                // Benchmark report
+                char buf[32];
+                UI::drawTitleBar(game.boardFull ? "Autoplay: board full" : "Autoplay: stopped");
+                snprintf(buf, sizeof(buf), "%lu moves/s %lu fps",
+                         stats.moves * 1000UL / stats.elapsedMs, stats.frames * 1000UL / stats.elapsedMs);
+                UI::drawCentered(22, buf);
+                snprintf(buf, sizeof(buf), "plan %lu step %lu us",
+                         average(stats.planUs, stats.moves),
+                         average(stats.stepUs, stats.moves));
+                UI::drawCentered(33, buf);
+                snprintf(buf, sizeof(buf), "draw %lu flush %lu us",
+                         average(stats.drawUs, stats.frames),
+                         average(stats.flushUs, stats.frames));
+                UI::drawCentered(44, buf);
+                UI::drawStatusBar("A:Again", "B:Exit");
+                break;
+            }
+
             UI::drawTitleBar("Game Over");
 
             {
                 char buf[32];
-                snprintf(buf, sizeof(buf), "Score: %d", score);
+                snprintf(buf, sizeof(buf), "Score: %d", game.score);
                 UI::drawCentered(28, buf);
 
-                if (score >= highScore) {
+                if (game.boardFull) {
+                    UI::drawCentered(40, "Board cleared!");
+                } else if (game.score >= highScore) {
                     UI::drawCentered(40, "NEW HIGH SCORE!");
                 } else {
                     snprintf(buf, sizeof(buf), "Best: %d", highScore);
                     UI::drawCentered(40, buf);
                 }
+
+                if (racingGhost) {
+                    snprintf(buf, sizeof(buf), "Ghost: %d", ghost.score);
+                    UI::drawCentered(50, buf);
+                }
             }
 
             UI::drawStatusBar("A:Again", "B:Exit");
             break;
     }
 
+    if (state == State::AUTOPLAY) {
+        frameDueAt = t0 + SNAKE_AUTOPLAY_FRAME_US;
+        unsigned long t1 = micros();
+        UI::flush();
+        stats.drawUs += t1 - t0;
+        stats.flushUs += micros() - t1;
+        stats.frames++;
+        return;
+    }
     UI::flush();
 }
 
@@ -211,8 +398,21 @@ void SnakeApp::onButton(uint8_t btn, bool pressed) {
 
     switch (state) {
         case State::MENU:
-            if (btn == BTN_A) {
-                startGame();
+            if (btn == BTN_UP && menuIndex > 0) {
+                menuIndex--;
+                UI::beep();
+            } else if (btn == BTN_DOWN && menuIndex < (hasBest ? MENU_WATCH : MENU_AUTOPLAY)) {
+                menuIndex++;
+                UI::beep();
+            } else if (btn == BTN_A) {
+                if (!hasBest && menuIndex > MENU_AUTOPLAY) menuIndex = MENU_PLAY;
+                if (menuIndex == MENU_AUTOPLAY) {
+                    startAutoplay();
+                } else if (menuIndex == MENU_WATCH) {
+                    startPlayback();
+                } else {
+                    startGame(menuIndex == MENU_RACE);
+                }
                 UI::beep();
             } else if (btn == BTN_B || btn == BTN_D) {
                 wantsToExit = true;
@@ -221,23 +421,38 @@ void SnakeApp::onButton(uint8_t btn, bool pressed) {
 
         case State::PLAYING:
             // Direction changes (prevent 180 degree turns)
-            if (btn == BTN_UP && direction != 1) {
+            if (btn == BTN_UP && game.direction != 1) {
                 nextDirection = 3;
-            } else if (btn == BTN_DOWN && direction != 3) {
+            } else if (btn == BTN_DOWN && game.direction != 3) {
                 nextDirection = 1;
-            } else if (btn == BTN_LEFT && direction != 0) {
+            } else if (btn == BTN_LEFT && game.direction != 0) {
                 nextDirection = 2;
-            } else if (btn == BTN_RIGHT && direction != 2) {
+            } else if (btn == BTN_RIGHT && game.direction != 2) {
                 nextDirection = 0;
             } else if (btn == BTN_D) {
-                state = State::GAME_OVER;
-                saveHighScore();
+                endGame();
+            }
+            break;
+
+        case State::REPLAY:
+            if (btn == BTN_B || btn == BTN_D) {
+                state = State::MENU;
+            }
+            break;
+
+        case State::AUTOPLAY:
+            if (btn == BTN_B || btn == BTN_D) {
+                finishAutoplay();
             }
             break;
 
         case State::GAME_OVER:
             if (btn == BTN_A) {
-                startGame();
+                if (autoplay) {
+                    startAutoplay();
+                } else {
+                    startGame(racingGhost);
+                }
                 UI::beep();
             } else if (btn == BTN_B || btn == BTN_D) {
                 wantsToExit = true;
@@ -0,0 +1,185 @@
+#include "apps/snake_game.h"
+#include <string.h>
+#include <algorithm>
+
+// Position of a cell on a Hamiltonian cycle through the whole grid: along
+// row 0, then back and forth over columns 1..31 down to the last row, and
+// up column 0 to the start. Needs an even grid height.
+static int cycleIndex(int x, int y) {
+    if (y == 0) return x;
+    if (x == 0) return SNAKE_CELLS - y;
+    int base = SNAKE_GRID_W + (y - 1) * (SNAKE_GRID_W - 1);
+    return (y & 1) ? base + (SNAKE_GRID_W - 1 - x) : base + (x - 1);
+}
+
+void SnakeGame::reset(uint32_t seed) {
+    // Initialize snake in center
+    snakeLen = 3;
+    snakeHead = 0;
+
+    int startX = SNAKE_GRID_W / 2;
+    int startY = SNAKE_GRID_H / 2;
+
+    // Head at snakeHead, body behind it in the circular buffer
+    memset(occupied, 0, sizeof(occupied));
+    for (int i = 0; i < snakeLen; i++) {
+        int idx = (snakeHead - i + SNAKE_MAX_LEN) % SNAKE_MAX_LEN;
+        snakeX[idx] = startX - i;
+        snakeY[idx] = startY;
+        setOccupied(startX - i, startY, true);
+    }
+
+    direction = 0;  // Moving right
+    score = 0;
+    moves = 0;
+    rng = seed;
+    alive = true;
+    boardFull = false;
+
+    spawnFood();
+}
+
+// LCG: plenty for food placement, and reproducible from the seed
+uint32_t SnakeGame::nextRandom(uint32_t n) {
+    rng = rng * 1664525 + 1013904223;
+    return (rng >> 16) % n;
+}
+
+bool SnakeGame::isOccupied(int x, int y) const {
+    int cell = y * SNAKE_GRID_W + x;
+    return occupied[cell >> 5] & (1UL << (cell & 31));
+}
+
+void SnakeGame::setOccupied(int x, int y, bool on) {
+    int cell = y * SNAKE_GRID_W + x;
+    if (on) {
+        occupied[cell >> 5] |= 1UL << (cell & 31);
+    } else {
+        occupied[cell >> 5] &= ~(1UL << (cell & 31));
+    }
+}
+
+// Picks uniformly among the free cells: draw n < free count, then find
+// the n-th clear bit, skipping whole words by popcount. At most 16 words
+// and 31 bit steps, however long the snake. False when the board is full.
+bool SnakeGame::spawnFood() {
+    int freeCells = SNAKE_CELLS - snakeLen;
+    if (freeCells <= 0) return false;
+
+    int n = nextRandom(freeCells);
+    for (int w = 0; w < SNAKE_CELLS / 32; w++) {
+        uint32_t freeBits = ~occupied[w];
+        int count = __builtin_popcount(freeBits);
+        if (n >= count) {
+            n -= count;
+            continue;
+        }
+        while (n--) freeBits &= freeBits - 1;   // Drop the lowest n free bits
+        int cell = w * 32 + __builtin_ctz(freeBits);
+        foodX = cell % SNAKE_GRID_W;
+        foodY = cell / SNAKE_GRID_W;
+        return true;
+    }
+    return false;
+}
+
+bool SnakeGame::checkCollision(int x, int y) const {
+    // Wall collision
+    if (x < 0 || x >= SNAKE_GRID_W || y < 0 || y >= SNAKE_GRID_H) {
+        return true;
+    }
+
+    // Self collision
+    return isOccupied(x, y);
+}
+
+uint8_t SnakeGame::step(int newDirection) {
+    if (!alive) return 0;
+    direction = newDirection;
+    moves++;
+
+    // Calculate new head position
+    int headX = snakeX[snakeHead];
+    int headY = snakeY[snakeHead];
+
+    switch (direction) {
+        case 0: headX++; break;  // Right
+        case 1: headY++; break;  // Down
+        case 2: headX--; break;  // Left
+        case 3: headY--; break;  // Up
+    }
+
+    // Check food
+    bool ateFood = (headX == foodX && headY == foodY);
+
+    // Unless growing, the tail moves on this step, so the head may take
+    // its cell
+    int tail = (snakeHead - snakeLen + 1 + SNAKE_MAX_LEN) % SNAKE_MAX_LEN;
+    if (!ateFood) {
+        setOccupied(snakeX[tail], snakeY[tail], false);
+    }
+
+    // Check collision
+    if (checkCollision(headX, headY)) {
+        if (!ateFood) setOccupied(snakeX[tail], snakeY[tail], true);
+        alive = false;
+        return STEP_DIED;
+    }
+
+    // Move head
+    snakeHead = (snakeHead + 1) % SNAKE_MAX_LEN;
+    snakeX[snakeHead] = headX;
+    snakeY[snakeHead] = headY;
+    setOccupied(headX, headY, true);
+
+    if (!ateFood) return 0;
+
+    score++;
+    snakeLen++;
+    if (!spawnFood()) {
+        // Every cell is snake
+        boardFull = true;
+        alive = false;
+        return STEP_ATE | STEP_FULL;
+    }
+    return STEP_ATE;
+}
+
+// Follows the Hamiltonian cycle, cutting ahead towards the food while the
+// cut lands before the tail (in cycle order). The body then always runs
+// in cycle order, so the snake can't trap itself and fills the board.
+int SnakeGame::planMove() const {
+    int headX = snakeX[snakeHead];
+    int headY = snakeY[snakeHead];
+    int tail = (snakeHead - snakeLen + 1 + SNAKE_MAX_LEN) % SNAKE_MAX_LEN;
+    int head = cycleIndex(headX, headY);
+
+    auto ahead = [head](int x, int y) {
+        return (cycleIndex(x, y) - head + SNAKE_CELLS) % SNAKE_CELLS;
+    };
+
+    // Room for growth before the tail; no cuts once half the board is
+    // snake, where a wrong one costs the most
+    int maxCut = 0;
+    if (snakeLen < SNAKE_CELLS / 2) {
+        maxCut = std::min(ahead(snakeX[tail], snakeY[tail]) - 4, ahead(foodX, foodY));
+    }
+
+    int bestDir = -1;
+    int bestDist = 0;
+    for (int dir = 0; dir < 4; dir++) {
+        int x = headX + (dir == 0) - (dir == 2);
+        int y = headY + (dir == 1) - (dir == 3);
+        if (x < 0 || x >= SNAKE_GRID_W || y < 0 || y >= SNAKE_GRID_H) continue;
+        if (isOccupied(x, y)) continue;
+
+        // The next cell on the cycle is always allowed
+        int dist = ahead(x, y);
+        if (dist != 1 && dist > maxCut) continue;
+        if (dist > bestDist) {
+            bestDir = dir;
+            bestDist = dist;
+        }
+    }
+    return bestDir >= 0 ? bestDir : direction;
+}
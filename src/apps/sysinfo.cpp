@@ -6,6 +6,7 @@
 
 void SysInfoApp::init() {
     currentPage = Page::INFO;
+    hostScroll = 0;
 }
 
 void SysInfoApp::update() {
@@ -15,13 +16,17 @@ void SysInfoApp::update() {
 void SysInfoApp::render() {
     UI::clear();
 
+    const char* statusLeft = "C:Next";
     if (currentPage == Page::INFO) {
         renderInfo();
+    } else if (currentPage == Page::NETWORK) {
+        renderNetwork();
+        statusLeft = "A:CSV C:Next";
     } else {
         renderButtonTest();
     }
 
-    UI::drawStatusBar("C:Toggle", "B:Back");
+    UI::drawStatusBar(statusLeft, "B:Back");
     UI::flush();
 }
 
@@ -67,6 +72,58 @@ void SysInfoApp::renderInfo() {
     UI::setNormalFont();
 }
 
+void SysInfoApp::renderNetwork() {
+    UI::drawTitleBar("Network");
+    UI::setSmallFont();
+
+    char buf[48];
+    uint32_t requests = 0;
+    int hostCount = WiFiManager::getHostCount();
+    for (int i = 0; i < hostCount; i++) {
+        requests += WiFiManager::getHostHealth(i)->requests;
+    }
+    const DnsStats& dns = WiFiManager::getDnsStats();
+    uint32_t lookups = dns.hits + dns.misses + dns.staleServed;
+    snprintf(buf, sizeof(buf), "Req %lu F%lu %luKB DNS %lu%%",
+             (unsigned long)requests, (unsigned long)WiFiManager::getTotalFailures(),
+             (unsigned long)(WiFiManager::getTotalRequestBytes() / 1024),
+             (unsigned long)(lookups ? dns.hits * 100 / lookups : 0));
+    u8g2.drawStr(2, 22, buf);
+
+    if (hostCount == 0) {
+        u8g2.drawStr(2, 34, "No requests yet");
+        UI::setNormalFont();
+        return;
+    }
+
+    // Per host: average total time, failures / requests
+    const int visible = 3;
+    if (hostScroll > hostCount - visible) hostScroll = max(0, hostCount - visible);
+    for (int i = 0; i < visible && hostScroll + i < hostCount; i++) {
+        const HostHealth* h = WiFiManager::getHostHealth(hostScroll + i);
+        uint32_t n = h->requests ? h->requests : 1;
+        uint32_t avgMs = (h->dnsMs + h->connectMs + h->ttfbMs + h->bodyMs) / n;
+
+        // Drop the "api." / "www." prefix to leave room for the numbers
+        const char* name = h->host;
+        if (strncmp(name, "api.", 4) == 0) name += 4;
+        else if (strncmp(name, "www.", 4) == 0) name += 4;
+
+        snprintf(buf, sizeof(buf), "%.14s", name);
+        u8g2.drawStr(2, 31 + i * 9, buf);
+        snprintf(buf, sizeof(buf), "%lums %lu/%lu", (unsigned long)avgMs,
+                 (unsigned long)h->failures, (unsigned long)h->requests);
+        int w = u8g2.getStrWidth(buf);
+        u8g2.drawStr(SCREEN_WIDTH - w - 6, 31 + i * 9, buf);
+    }
+
+    if (hostCount > visible) {
+        UI::drawScrollbar(125, 24, 28, hostScroll, hostCount, visible);
+    }
+
+    UI::setNormalFont();
+}
+
 void SysInfoApp::renderButtonTest() {
     UI::drawTitleBar("Button Test");
 
@@ -125,8 +182,17 @@ void SysInfoApp::onButton(uint8_t btn, bool pressed) {
     if (!pressed) return;
 
     if (btn == BTN_C) {
-        currentPage = (currentPage == Page::INFO) ? Page::BUTTON_TEST : Page::INFO;
+        if (currentPage == Page::INFO) currentPage = Page::NETWORK;
+        else if (currentPage == Page::NETWORK) currentPage = Page::BUTTON_TEST;
+        else currentPage = Page::INFO;
         UI::beep();
+    } else if (currentPage == Page::NETWORK && btn == BTN_UP) {
+        if (hostScroll > 0) hostScroll--;
+    } else if (currentPage == Page::NETWORK && btn == BTN_DOWN) {
+        if (hostScroll < WiFiManager::getHostCount() - 3) hostScroll++;
+    } else if (currentPage == Page::NETWORK && btn == BTN_A) {
+        WiFiManager::dumpTelemetryCsv(Serial);
+        UI::beep(1000, 50);
     } else if (btn == BTN_B || btn == BTN_D) {
         wantsToExit = true;
     }
@@ -2,15 +2,52 @@
 #include "ui.h"
 #include "icons.h"
 #include "input.h"
+#include "audio.h"
 
 extern U8G2_SH1106_128X64_NONAME_F_HW_I2C u8g2;
 
+// Five beeps
+static const char* ALARM_RTTTL = "alarm:d=8,o=7,b=240:c,16p,c,16p,c,16p,c,16p,c";
+
+void TimerApp::Span::start() {
+    startedAt = esp_timer_get_time();
+    running = true;
+}
+
+void TimerApp::Span::pause() {
+    accumulated = elapsed();
+    running = false;
+}
+
+void TimerApp::Span::reset() {
+    accumulated = 0;
+    running = false;
+}
+
+int64_t TimerApp::Span::elapsed() const {
+    return accumulated + (running ? esp_timer_get_time() - startedAt : 0);
+}
+
 void TimerApp::init() {
-    mode = Mode::SELECT;
-    state = State::STOPPED;
+    if (!alarmTimer) {
+        esp_timer_create_args_t args = {};
+        args.callback = onAlarm;
+        args.arg = this;
+        args.dispatch_method = ESP_TIMER_TASK;
+        args.name = "timer_alarm";
+        esp_timer_create(&args, &alarmTimer);
+    }
+    checkAlarm();
+
+    // Timers run on while the app is closed; reopen on the one in use
+    if (countdownState != State::STOPPED) {
+        mode = Mode::COUNTDOWN;
+    } else if (stopwatchState != State::STOPPED) {
+        mode = Mode::STOPWATCH;
+    } else {
+        mode = Mode::SELECT;
+    }
     selectIndex = 0;
-    elapsedTime = 0;
-    pausedTime = 0;
     setHours = 0;
     setMinutes = 5;
     setSeconds = 0;
@@ -18,17 +55,7 @@ void TimerApp::init() {
 }
 
 void TimerApp::update() {
-    if (state == State::RUNNING) {
-        unsigned long now = millis();
-        elapsedTime = pausedTime + (now - startMillis);
-
-        // Check countdown completion
-        if (mode == Mode::COUNTDOWN && elapsedTime >= targetTime) {
-            elapsedTime = targetTime;
-            state = State::FINISHED;
-            playAlarm();
-        }
-    }
+    checkAlarm();
 }
 
 void TimerApp::render() {
@@ -122,14 +149,15 @@ void TimerApp::renderCountdownSetup() {
 void TimerApp::renderCountdown() {
     UI::drawTitleBar("Countdown");
 
-    unsigned long remaining = 0;
-    if (elapsedTime < targetTime) {
-        remaining = targetTime - elapsedTime;
+    int64_t remaining = 0;
+    if (countdownState != State::FINISHED) {
+        remaining = max((int64_t)0, targetUs - countdown.elapsed());
     }
 
-    // Large centered time display
+    // Large centered time display, rounded up so 00:00 is the alarm
     char timeStr[12];
-    formatTime(remaining, timeStr, remaining >= 3600000);
+    unsigned long remainingMs = (remaining + 999999) / 1000000 * 1000;
+    formatTime(remainingMs, timeStr, remainingMs >= 3600000);
 
     u8g2.setFont(u8g2_font_logisoso22_tn);
     int w = u8g2.getStrWidth(timeStr);
@@ -137,8 +165,8 @@ void TimerApp::renderCountdown() {
 
     // Progress bar - shows remaining time (depletes as countdown progresses)
     int progress = 0;
-    if (targetTime > 0) {
-        progress = (int)((remaining * 100) / targetTime);
+    if (targetUs > 0) {
+        progress = (int)((remaining * 100) / targetUs);
         if (progress > 100) progress = 100;
     }
     UI::drawProgressBar(14, 44, 100, 6, progress);
@@ -146,9 +174,9 @@ void TimerApp::renderCountdown() {
     // Status text - only show when paused or finished
     UI::setSmallFont();
     const char* statusText = "";
-    if (state == State::FINISHED) {
+    if (countdownState == State::FINISHED) {
         statusText = "TIME'S UP!";
-    } else if (state == State::PAUSED) {
+    } else if (countdownState == State::PAUSED) {
         statusText = "PAUSED";
     }
     if (strlen(statusText) > 0) {
@@ -158,11 +186,11 @@ void TimerApp::renderCountdown() {
 
     UI::setNormalFont();
 
-    if (state == State::FINISHED) {
+    if (countdownState == State::FINISHED) {
         UI::drawStatusBar("A:Reset", "B:Back");
-    } else if (state == State::PAUSED) {
+    } else if (countdownState == State::PAUSED) {
         UI::drawStatusBar("A:Resume B:Reset", "D:Back");
-    } else if (state == State::RUNNING) {
+    } else if (countdownState == State::RUNNING) {
         UI::drawStatusBar("A:Pause", "B:Reset");
     } else {
         UI::drawStatusBar("A:Start", "B:Back");
@@ -174,18 +202,31 @@ void TimerApp::renderStopwatch() {
 
     // Large time display
     char timeStr[12];
-    formatTime(elapsedTime, timeStr, true);
+    formatSplit(stopwatch.elapsed(), timeStr);
 
     u8g2.setFont(u8g2_font_logisoso22_tn);
     int w = u8g2.getStrWidth(timeStr);
     u8g2.drawStr((128 - w) / 2, 38, timeStr);
 
+    // One lap at a time: split, then time at the lap. U/D for older ones.
+    if (lapCount > 0) {
+        int n = lapCount - 1 - lapView;
+        char split[12];
+        char total[12];
+        char line[32];
+        formatSplit(lapAt(n) - lapAt(n - 1), split);
+        formatSplit(lapAt(n), total);
+        snprintf(line, sizeof(line), "Lap %d %s %s", n + 1, split, total);
+        UI::setSmallFont();
+        UI::drawCentered(50, line);
+    }
+
     UI::setNormalFont();
 
-    if (state == State::PAUSED) {
+    if (stopwatchState == State::PAUSED) {
         UI::drawStatusBar("A:Resume B:Reset", "D:Back");
-    } else if (state == State::RUNNING) {
-        UI::drawStatusBar("A:Pause", "B:Reset");
+    } else if (stopwatchState == State::RUNNING) {
+        UI::drawStatusBar("A:Pause C:Lap", "B:Reset");
     } else {
         UI::drawStatusBar("A:Start", "B:Back");
     }
@@ -204,17 +245,94 @@ void TimerApp::formatTime(unsigned long ms, char* buf, bool showHours) {
     }
 }
 
-void TimerApp::playAlarm() {
-    // Play alarm beeps
-    for (int i = 0; i < 5; i++) {
-        UI::beep(2000, 100);
-        delay(150);
+// Hundredths under an hour, whole seconds past it
+void TimerApp::formatSplit(int64_t us, char* buf) {
+    unsigned long cs = us / 10000;
+    if (cs >= 360000) {
+        formatTime(cs * 10, buf, true);
+        return;
     }
+    snprintf(buf, 12, "%02lu:%02lu.%02lu", cs / 6000, cs / 100 % 60, cs % 100);
+}
+
+void TimerApp::startCountdown() {
+    targetUs = (int64_t)(setHours * 3600 + setMinutes * 60 + setSeconds) * 1000000;
+    if (targetUs == 0) return;
+    mode = Mode::COUNTDOWN;
+    countdown.reset();
+    resumeCountdown();
+}
+
+void TimerApp::pauseCountdown() {
+    // Fails once the alarm has gone off; checkAlarm() picks that up
+    if (esp_timer_stop(alarmTimer) != ESP_OK) return;
+    countdown.pause();
+    countdownState = State::PAUSED;
+    Input::setWakeAlarm(0);
+}
+
+void TimerApp::resumeCountdown() {
+    countdown.start();
+    alarmFired = false;
+    countdownState = State::RUNNING;
+    armAlarm();
+}
+
+void TimerApp::resetCountdown() {
+    esp_timer_stop(alarmTimer);
+    countdown.reset();
+    alarmFired = false;
+    countdownState = State::STOPPED;
+    Input::setWakeAlarm(0);
+}
+
+void TimerApp::armAlarm() {
+    int64_t remaining = max((int64_t)1, targetUs - countdown.elapsed());
+    esp_timer_start_once(alarmTimer, remaining);
+    // Light sleep would hold the alarm until a key press
+    Input::setWakeAlarm(esp_timer_get_time() + remaining);
+}
+
+// Main loop side of the alarm
+void TimerApp::checkAlarm() {
+    if (countdownState == State::RUNNING && alarmFired) {
+        countdownState = State::FINISHED;
+        mode = Mode::COUNTDOWN;
+        Input::setWakeAlarm(0);
+    }
+}
+
+// esp_timer task, at the end of the countdown
+void TimerApp::onAlarm(void* arg) {
+    TimerApp* app = (TimerApp*)arg;
+    app->alarmFired = true;
+    // checkAlarm() only runs with the app open
+    Input::setWakeAlarm(0);
+    Audio::play(ALARM_RTTTL, AUDIO_PRIO_ALARM);
+}
+
+void TimerApp::resetStopwatch() {
+    stopwatch.reset();
+    stopwatchState = State::STOPPED;
+    lapCount = 0;
+    lapView = 0;
+}
+
+void TimerApp::recordLap() {
+    laps[lapCount % TIMER_MAX_LAPS] = stopwatch.elapsed();
+    lapCount++;
+    lapView = 0;
+}
+
+int64_t TimerApp::lapAt(int n) {
+    return n < 0 ? 0 : laps[n % TIMER_MAX_LAPS];
 }
 
 void TimerApp::onButton(uint8_t btn, bool pressed) {
     if (!pressed) return;
 
+    // Any key silences the alarm
+    if (countdownState == State::FINISHED) Audio::stop();
     UI::beep();
 
     switch (mode) {
@@ -222,14 +340,13 @@ void TimerApp::onButton(uint8_t btn, bool pressed) {
             if (btn == BTN_UP && selectIndex > 0) selectIndex--;
             else if (btn == BTN_DOWN && selectIndex < 1) selectIndex++;
             else if (btn == BTN_A) {
-                if (selectIndex == 0) {
+                if (selectIndex == 1) {
+                    mode = Mode::STOPWATCH;
+                } else if (countdownState != State::STOPPED) {
+                    mode = Mode::COUNTDOWN;
+                } else {
                     mode = Mode::COUNTDOWN_SETUP;
                     setupIndex = 1;  // Start on minutes
-                } else {
-                    mode = Mode::STOPWATCH;
-                    state = State::STOPPED;
-                    elapsedTime = 0;
-                    pausedTime = 0;
                 }
             } else if (btn == BTN_B || btn == BTN_D) {
                 wantsToExit = true;
@@ -248,15 +365,7 @@ void TimerApp::onButton(uint8_t btn, bool pressed) {
                 else if (setupIndex == 1) setMinutes = (setMinutes + 59) % 60;
                 else setSeconds = (setSeconds + 59) % 60;
             } else if (btn == BTN_A) {
-                // Start countdown
-                targetTime = (unsigned long)(setHours * 3600 + setMinutes * 60 + setSeconds) * 1000;
-                if (targetTime > 0) {
-                    mode = Mode::COUNTDOWN;
-                    state = State::RUNNING;
-                    elapsedTime = 0;
-                    pausedTime = 0;
-                    startMillis = millis();
-                }
+                startCountdown();
             } else if (btn == BTN_B) {
                 mode = Mode::SELECT;
             }
@@ -264,62 +373,52 @@ void TimerApp::onButton(uint8_t btn, bool pressed) {
 
         case Mode::COUNTDOWN:
             if (btn == BTN_A) {
-                if (state == State::RUNNING) {
-                    // Pause
-                    state = State::PAUSED;
-                    pausedTime = elapsedTime;
-                } else if (state == State::PAUSED) {
-                    // Resume
-                    state = State::RUNNING;
-                    startMillis = millis();
-                } else if (state == State::FINISHED) {
-                    // Reset
-                    state = State::STOPPED;
-                    elapsedTime = 0;
-                    pausedTime = 0;
+                if (countdownState == State::RUNNING) {
+                    pauseCountdown();
+                } else if (countdownState == State::PAUSED) {
+                    resumeCountdown();
+                } else if (countdownState == State::FINISHED) {
+                    resetCountdown();
                     mode = Mode::COUNTDOWN_SETUP;
                 }
             } else if (btn == BTN_B) {
-                if (state == State::RUNNING || state == State::PAUSED) {
-                    // Reset
-                    state = State::STOPPED;
-                    elapsedTime = 0;
-                    pausedTime = 0;
-                } else {
+                // Reset, or back to the menu if there's nothing to reset
+                if (countdownState != State::RUNNING && countdownState != State::PAUSED) {
                     mode = Mode::SELECT;
                 }
+                resetCountdown();
             } else if (btn == BTN_D) {
-                state = State::STOPPED;
-                elapsedTime = 0;
-                pausedTime = 0;
+                // Back to the menu; a running countdown carries on
+                if (countdownState == State::FINISHED) resetCountdown();
                 mode = Mode::SELECT;
             }
             break;
 
         case Mode::STOPWATCH:
             if (btn == BTN_A) {
-                if (state == State::RUNNING) {
-                    // Pause
-                    state = State::PAUSED;
-                    pausedTime = elapsedTime;
-                } else if (state == State::PAUSED || state == State::STOPPED) {
-                    // Start/Resume
-                    state = State::RUNNING;
-                    startMillis = millis();
+                if (stopwatchState == State::RUNNING) {
+                    stopwatch.pause();
+                    stopwatchState = State::PAUSED;
+                } else {
+                    stopwatch.start();
+                    stopwatchState = State::RUNNING;
                 }
             } else if (btn == BTN_B) {
-                if (state == State::RUNNING || state == State::PAUSED) {
-                    // Reset
-                    state = State::STOPPED;
-                    elapsedTime = 0;
-                    pausedTime = 0;
+                if (stopwatchState == State::RUNNING || stopwatchState == State::PAUSED) {
+                    resetStopwatch();
                 } else {
                     mode = Mode::SELECT;
                 }
+            } else if (btn == BTN_C && stopwatchState == State::RUNNING) {
+                recordLap();
+            } else if (btn == BTN_UP) {
+                // Older laps, as far as the ring buffer still has their start
+                int viewable = lapCount <= TIMER_MAX_LAPS ? lapCount : TIMER_MAX_LAPS - 1;
+                if (lapView < viewable - 1) lapView++;
+            } else if (btn == BTN_DOWN && lapView > 0) {
+                lapView--;
             } else if (btn == BTN_D) {
-                state = State::STOPPED;
-                elapsedTime = 0;
-                pausedTime = 0;
+                // Back to the menu; a running stopwatch carries on
                 mode = Mode::SELECT;
             }
             break;
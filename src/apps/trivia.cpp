@@ -13,7 +13,10 @@ void TriviaApp::init() {
 }
 
 void TriviaApp::update() {
-    // No auto-update
+    // Top up the prefetch queue while a question is on screen
+    if (WiFiManager::canFetch() && queue.wantsRefill()) {
+        queue.refill();
+    }
 }
 
 void TriviaApp::decodeHtml(char* str) {
@@ -47,60 +50,83 @@ void TriviaApp::decodeHtml(char* str) {
     *write = '\0';
 }
 
-void TriviaApp::fetchQuestion() {
-    if (!WiFiManager::isConnected()) {
-        strcpy(errorMsg, "No WiFi");
-        return;
-    }
-
-    loading = true;
+int TriviaApp::fillQueue(PrefetchQueue<TriviaItem, PREFETCH_DEPTH>& q, int wanted) {
+    // Open Trivia Database - batch several questions per request
+    char url[72];
+    snprintf(url, sizeof(url), "https://opentdb.com/api.php?amount=%d&type=multiple", wanted);
 
-    // Open Trivia Database
-    String response = WiFiManager::httpGet("https://opentdb.com/api.php?amount=1&type=multiple");
-    loading = false;
+    String response = WiFiManager::httpGet(url);
+    if (response.length() == 0) return 0;
 
-    if (response.length() == 0) {
-        strcpy(errorMsg, "Network error");
-        return;
-    }
-
-    // Parse JSON
-    DynamicJsonDocument doc(2048);
+    DynamicJsonDocument doc(1024 * PREFETCH_DEPTH);
     DeserializationError error = deserializeJson(doc, response);
+    if (error) return 0;
+
+    // Non-zero codes include the 5 s per-IP rate limit
+    if (doc["response_code"] != 0) return 0;
+
+    int added = 0;
+    for (JsonObject q0 : doc["results"].as<JsonArray>()) {
+        TriviaItem* slot = q.nextFree();
+        if (!slot) break;
+
+        const char* questionText = q0["question"] | "";
+        const char* correct = q0["correct_answer"] | "";
+        JsonArray incorrect = q0["incorrect_answers"];
+
+        strncpy(slot->question, questionText, sizeof(slot->question) - 1);
+        slot->question[sizeof(slot->question) - 1] = '\0';
+        decodeHtml(slot->question);
+
+        // Shuffle answers
+        slot->correct = random(0, 4);
+
+        size_t idx = 0;
+        for (int i = 0; i < 4; i++) {
+            slot->answers[i][0] = '\0';
+            if (i == slot->correct) {
+                strncpy(slot->answers[i], correct, sizeof(slot->answers[0]) - 1);
+            } else if (idx < incorrect.size()) {
+                strncpy(slot->answers[i], incorrect[idx].as<const char*>(), sizeof(slot->answers[0]) - 1);
+                idx++;
+            }
+            slot->answers[i][sizeof(slot->answers[0]) - 1] = '\0';
+            decodeHtml(slot->answers[i]);
+        }
 
-    if (error) {
-        strcpy(errorMsg, "Parse error");
-        return;
+        q.commit();
+        added++;
     }
 
-    if (doc["response_code"] != 0) {
-        strcpy(errorMsg, "API error");
-        return;
-    }
+    return added;
+}
 
-    JsonObject q = doc["results"][0];
-    const char* questionText = q["question"] | "";
-    const char* correct = q["correct_answer"] | "";
-    JsonArray incorrect = q["incorrect_answers"];
+void TriviaApp::fetchQuestion() {
+    if (queue.isEmpty()) {
+        if (!WiFiManager::canFetch()) {
+            strcpy(errorMsg, "No WiFi");
+            return;
+        }
 
-    strncpy(question, questionText, sizeof(question) - 1);
-    decodeHtml(question);
+        // Nothing prefetched yet - fetch in the foreground
+        loading = true;
+        queue.refill();
+        loading = false;
+
+        if (queue.isEmpty()) {
+            strcpy(errorMsg, "Network error");
+            return;
+        }
+    }
 
-    // Shuffle answers
-    correctAnswer = random(0, 4);
+    TriviaItem item;
+    queue.pop(item);
 
-    int idx = 0;
+    strcpy(question, item.question);
     for (int i = 0; i < 4; i++) {
-        if (i == correctAnswer) {
-            strncpy(answers[i], correct, sizeof(answers[0]) - 1);
-        } else {
-            if (idx < incorrect.size()) {
-                strncpy(answers[i], incorrect[idx].as<const char*>(), sizeof(answers[0]) - 1);
-                idx++;
-            }
-        }
-        decodeHtml(answers[i]);
+        strcpy(answers[i], item.answers[i]);
     }
+    correctAnswer = item.correct;
 
     selectedAnswer = 0;
     answered = false;
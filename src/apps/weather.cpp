@@ -4,15 +4,49 @@
 #include "icons.h"
 #include "config.h"
 #include "keyboard.h"
+#include "data_store.h"
 #include <ArduinoJson.h>
 #include <Preferences.h>
 
+static const char* WEATHER_HOST_URL = "http://api.openweathermap.org/";
+
+struct WeatherRecord {
+    char city[32];
+    float temp;
+    int32_t humidity;
+    char description[32];
+};
+
 void WeatherApp::init() {
     hasData = false;
     loading = false;
     searching = false;
+    stale = false;
+    lastAttempt = 0;
     errorMsg[0] = '\0';
     loadCity();
+    loadCached();
+}
+
+void WeatherApp::loadCached() {
+    WeatherRecord rec;
+    if (!DataStore::load("weather", &rec, sizeof(rec))) return;
+    if (strcmp(rec.city, city) != 0) return;  // Saved for a different city
+
+    temp = rec.temp;
+    humidity = rec.humidity;
+    memcpy(description, rec.description, sizeof(description));
+    hasData = true;
+    stale = true;
+}
+
+void WeatherApp::saveCached() {
+    WeatherRecord rec;
+    memcpy(rec.city, city, sizeof(rec.city));
+    rec.temp = temp;
+    rec.humidity = humidity;
+    memcpy(rec.description, description, sizeof(rec.description));
+    DataStore::save("weather", &rec, sizeof(rec));
 }
 
 void WeatherApp::loadCity() {
@@ -39,6 +73,7 @@ void WeatherApp::update() {
             saveCity();
             searching = false;
             hasData = false;
+            stale = false;
             fetchWeather();
         } else if (Keyboard::isCancelled()) {
             searching = false;
@@ -46,18 +81,25 @@ void WeatherApp::update() {
         return;
     }
 
-    // Auto-refresh every 5 minutes
-    if (hasData && millis() - lastFetch > 300000) {
-        fetchWeather();
-    }
+    // Refresh periodically while data is on screen; cached data and failed
+    // refreshes retry sooner, but never before the host's backoff expires
+    if (!hasData || !WiFiManager::canFetch()) return;
+    unsigned long interval = (stale || errorMsg[0]) ? 10000 : 300000;
+    if (lastAttempt != 0 && millis() - lastAttempt < interval) return;
+    if (WiFiManager::getRetryDelay(WEATHER_HOST_URL) > 0) return;
+
+    fetchWeather();
+    if (stale) errorMsg[0] = '\0';  // Keep cached conditions on screen
 }
 
 void WeatherApp::fetchWeather() {
-    if (!WiFiManager::isConnected()) {
+    if (!WiFiManager::canFetch()) {
         strcpy(errorMsg, "No WiFi");
         return;
     }
 
+    lastAttempt = millis();
+
     // Get API key (use default from config if NVS is empty)
     Preferences prefs;
     prefs.begin(NVS_NAMESPACE, true);
@@ -111,21 +153,22 @@ void WeatherApp::fetchWeather() {
     strncpy(description, desc, sizeof(description) - 1);
 
     hasData = true;
+    stale = false;
     errorMsg[0] = '\0';
     lastFetch = millis();
+    saveCached();
 }
 
 void WeatherApp::render() {
     UI::clear();
     UI::drawTitleBar("Weather");
+    if (stale) UI::drawStaleTag();
 
     if (loading) {
         UI::drawCentered(35, "Loading...");
     } else if (strlen(errorMsg) > 0) {
         UI::drawCentered(30, errorMsg);
-        UI::setSmallFont();
-        UI::drawCentered(45, "Press A to retry");
-        UI::setNormalFont();
+        UI::drawRetryHint(45, WiFiManager::getRetryDelay(WEATHER_HOST_URL), "Press A to retry");
     } else if (!hasData) {
         UI::drawCentered(30, "Press A to fetch");
         UI::setSmallFont();
@@ -0,0 +1,261 @@
+#include "audio.h"
+#include "config.h"
+
+esp_timer_handle_t Audio::timer = nullptr;
+portMUX_TYPE Audio::mux = portMUX_INITIALIZER_UNLOCKED;
+bool Audio::armed = false;
+uint32_t Audio::epoch = 0;
+Audio::Sound Audio::current;
+bool Audio::playing = false;
+Audio::Sound Audio::queue[AUDIO_QUEUE_SIZE];
+int Audio::queued = 0;
+volatile uint32_t Audio::dropped = 0;
+
+// Octave 4, C to B; other octaves are shifts of these
+static const uint16_t OCTAVE4_HZ[12] = {
+    262, 277, 294, 311, 330, 349, 370, 392, 415, 440, 466, 494
+};
+
+void Audio::init() {
+    if (timer) return;
+    ledcSetup(AUDIO_LEDC_CHANNEL, BEEP_FREQ, 10);
+    ledcAttachPin(BUZZER_PIN, AUDIO_LEDC_CHANNEL);
+    ledcWrite(AUDIO_LEDC_CHANNEL, 0);
+
+    esp_timer_create_args_t args = {};
+    args.callback = onTimer;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "audio";
+    esp_timer_create(&args, &timer);
+}
+
+void Audio::tone(uint16_t freq, uint16_t ms, uint8_t priority) {
+    Sound s = {};
+    s.freq = freq;
+    s.ms = ms;
+    s.priority = priority;
+    submit(s);
+}
+
+void Audio::play(const char* rtttl, uint8_t priority) {
+    Sound s = {};
+    s.rtttl = rtttl;
+    s.priority = priority;
+    parseHeader(s);
+    submit(s);
+}
+
+void Audio::stop() {
+    if (!timer) return;
+    portENTER_CRITICAL(&mux);
+    playing = false;
+    queued = 0;
+    epoch++;
+    bool wasIdle = !armed;
+    armed = true;
+    portEXIT_CRITICAL(&mux);
+    preempt(wasIdle);
+}
+
+bool Audio::isPlaying() {
+    return playing;
+}
+
+uint32_t Audio::getDroppedCount() {
+    return dropped;
+}
+
+void Audio::submit(Sound& s) {
+    if (!timer) return;
+
+    bool start = false;
+    bool wasIdle = false;
+    portENTER_CRITICAL(&mux);
+    if (!playing || s.priority >= current.priority) {
+        // A melody cut short picks up again later
+        if (playing && current.rtttl && !enqueue(current)) dropped++;
+        current = s;
+        playing = true;
+        epoch++;
+        wasIdle = !armed;
+        armed = true;
+        start = true;
+    } else if (!s.rtttl || !enqueue(s)) {
+        dropped++;
+    }
+    portEXIT_CRITICAL(&mux);
+
+    if (start) preempt(wasIdle);
+}
+
+// Runs the callback now instead of at the end of the current note. If
+// the timer is neither idle nor armed, the callback is running and
+// notices the epoch change itself.
+void Audio::preempt(bool wasIdle) {
+    if (wasIdle || esp_timer_stop(timer) == ESP_OK) {
+        esp_timer_start_once(timer, 0);
+    }
+}
+
+// Keeps the queue ordered by priority, first come first among equals.
+// Called with mux held.
+bool Audio::enqueue(const Sound& s) {
+    if (queued >= AUDIO_QUEUE_SIZE) return false;
+    int i = queued;
+    while (i > 0 && queue[i - 1].priority < s.priority) {
+        queue[i] = queue[i - 1];
+        i--;
+    }
+    queue[i] = s;
+    queued++;
+    return true;
+}
+
+// "name:d=4,o=6,b=63:" with any of the defaults left out
+void Audio::parseHeader(Sound& s) {
+    s.defDuration = 4;
+    s.defOctave = 6;
+    int bpm = 63;
+
+    const char* p = strchr(s.rtttl, ':');
+    if (!p) {
+        s.pos = strlen(s.rtttl);
+        return;
+    }
+    p++;
+    while (*p && *p != ':') {
+        char key = *p;
+        p++;
+        if (*p != '=') {
+            p++;
+            continue;
+        }
+        int value = atoi(++p);
+        while (isdigit((unsigned char)*p)) p++;
+        if (key == 'd' && value > 0) s.defDuration = value;
+        if (key == 'o' && value >= 3 && value <= 7) s.defOctave = value;
+        if (key == 'b' && value > 0) bpm = value;
+        if (*p == ',') p++;
+    }
+    if (*p == ':') p++;
+    s.pos = p - s.rtttl;
+    s.wholeMs = 60000UL * 4 / bpm;
+}
+
+// Next tone (freq > 0) or silence, false once the sound is over. Called
+// with mux held; one RTTTL note is a few dozen characters at most.
+bool Audio::nextNote(Sound& s, uint16_t& freq, uint16_t& ms) {
+    if (s.gapMs) {
+        freq = 0;
+        ms = s.gapMs;
+        s.gapMs = 0;
+        return true;
+    }
+
+    if (!s.rtttl) {
+        if (!s.freq) return false;
+        freq = s.freq;
+        ms = s.ms;
+        s.freq = 0;
+        return true;
+    }
+
+    static const int8_t SEMITONE[7] = {9, 11, 0, 2, 4, 5, 7};  // a..g
+    const char* p = s.rtttl + s.pos;
+    while (true) {
+        while (*p == ',' || *p == ' ') p++;
+        if (!*p) {
+            s.pos = p - s.rtttl;
+            return false;
+        }
+
+        int duration = 0;
+        while (isdigit((unsigned char)*p)) duration = duration * 10 + (*p++ - '0');
+        if (duration <= 0) duration = s.defDuration;
+
+        char name = tolower((unsigned char)*p);
+        int semitone;
+        if (name >= 'a' && name <= 'g') {
+            semitone = SEMITONE[name - 'a'];
+        } else if (name == 'p') {
+            semitone = -1;
+        } else {
+            // Not a note: skip to the next one
+            while (*p && *p != ',') p++;
+            continue;
+        }
+        p++;
+
+        bool dotted = false;
+        if (*p == '#') {
+            semitone++;
+            p++;
+        }
+        if (*p == '.') {
+            dotted = true;
+            p++;
+        }
+        int octave = s.defOctave;
+        if (*p >= '3' && *p <= '7') octave = *p++ - '0';
+        if (*p == '.') {
+            dotted = true;
+            p++;
+        }
+        s.pos = p - s.rtttl;
+
+        ms = s.wholeMs / duration;
+        if (dotted) ms += ms / 2;
+        if (semitone < 0) {
+            freq = 0;
+            return true;
+        }
+
+        int octaveShift = octave - 4 + semitone / 12;
+        uint16_t hz = OCTAVE4_HZ[semitone % 12];
+        freq = octaveShift >= 0 ? hz << octaveShift : hz >> -octaveShift;
+        // Short silence after each note so repeated notes stay distinct
+        s.gapMs = ms / 8;
+        ms -= s.gapMs;
+        return true;
+    }
+}
+
+// esp_timer task: set the buzzer for the next note, arm the timer for
+// its end
+void Audio::onTimer(void* arg) {
+    while (true) {
+        uint16_t freq = 0;
+        uint16_t ms = 0;
+
+        portENTER_CRITICAL(&mux);
+        uint32_t seen = epoch;
+        while (playing && !nextNote(current, freq, ms)) {
+            // Finished: carry on with the most important queued melody
+            playing = queued > 0;
+            if (playing) {
+                current = queue[0];
+                queued--;
+                memmove(queue, queue + 1, queued * sizeof(Sound));
+            }
+        }
+        bool active = playing;
+        if (!active) armed = false;
+        portEXIT_CRITICAL(&mux);
+
+        if (active && freq) {
+            ledcWriteTone(AUDIO_LEDC_CHANNEL, freq);
+        } else {
+            ledcWrite(AUDIO_LEDC_CHANNEL, 0);
+        }
+        if (!active) return;
+
+        esp_timer_start_once(timer, (uint64_t)ms * 1000);
+
+        // A sound submitted while this ran couldn't stop the timer; take
+        // the timer back and start it now rather than after this note
+        portENTER_CRITICAL(&mux);
+        bool replaced = epoch != seen;
+        portEXIT_CRITICAL(&mux);
+        if (!replaced || esp_timer_stop(timer) != ESP_OK) return;
+    }
+}
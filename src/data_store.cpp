@@ -0,0 +1,156 @@
+#include "data_store.h"
+#include <LittleFS.h>
+#include <time.h>
+
+bool DataStore::mounted = false;
+
+static const uint16_t RECORD_MAGIC = 0xD5A7;
+static const uint32_t MIN_VALID_EPOCH = 1600000000;  // Before this, NTP hasn't synced
+
+struct RecordHeader {
+    uint16_t magic;
+    uint16_t len;
+    uint16_t crc;
+    uint16_t reserved;
+    uint32_t savedAt;
+};
+
+bool DataStore::init() {
+    mounted = LittleFS.begin(true);
+    if (!mounted) {
+        Serial.println("LittleFS mount failed");
+        return false;
+    }
+    if (!LittleFS.exists("/ds")) {
+        LittleFS.mkdir("/ds");
+    }
+    return true;
+}
+
+bool DataStore::isMounted() {
+    return mounted;
+}
+
+void DataStore::makePath(const char* key, char* path, size_t len, bool temp) {
+    snprintf(path, len, "/ds/%s%s", key, temp ? ".tmp" : ".bin");
+}
+
+uint16_t DataStore::crc16(const uint8_t* data, uint16_t len) {
+    // CRC-16/CCITT-FALSE
+    uint16_t crc = 0xFFFF;
+    for (uint16_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+bool DataStore::save(const char* key, const void* data, uint16_t len) {
+    if (!mounted) return false;
+
+    RecordHeader hdr;
+    hdr.magic = RECORD_MAGIC;
+    hdr.len = len;
+    hdr.crc = crc16((const uint8_t*)data, len);
+    hdr.reserved = 0;
+    time_t now = time(nullptr);
+    hdr.savedAt = (now >= (time_t)MIN_VALID_EPOCH) ? (uint32_t)now : 0;
+
+    // Write to a temp file and rename over the record (atomic on
+    // LittleFS), so a power cut never leaves a half-written record behind
+    char tmpPath[40], path[40];
+    makePath(key, tmpPath, sizeof(tmpPath), true);
+    makePath(key, path, sizeof(path), false);
+
+    File f = LittleFS.open(tmpPath, FILE_WRITE);
+    if (!f) return false;
+
+    bool ok = f.write((const uint8_t*)&hdr, sizeof(hdr)) == sizeof(hdr) &&
+              f.write((const uint8_t*)data, len) == len;
+    f.close();
+
+    if (!ok) {
+        LittleFS.remove(tmpPath);
+        return false;
+    }
+
+    return LittleFS.rename(tmpPath, path);
+}
+
+bool DataStore::load(const char* key, void* data, uint16_t len, uint32_t* savedAt) {
+    if (!mounted) return false;
+
+    char path[40], tmpPath[40];
+    makePath(key, path, sizeof(path), false);
+    makePath(key, tmpPath, sizeof(tmpPath), true);
+
+    uint32_t at = 0;
+    bool ok = readRecord(path, data, len, &at);
+
+    // A complete temp file is a save that was cut off before its rename,
+    // so it wins unless the record is newer
+    if (LittleFS.exists(tmpPath)) {
+        uint8_t* tmp = (uint8_t*)malloc(len);
+        uint32_t tmpAt = 0;
+        if (tmp && readRecord(tmpPath, tmp, len, &tmpAt) && (!ok || tmpAt >= at)) {
+            memcpy(data, tmp, len);
+            at = tmpAt;
+            ok = true;
+        }
+        free(tmp);
+    }
+
+    if (ok && savedAt) *savedAt = at;
+    return ok;
+}
+
+bool DataStore::readRecord(const char* path, void* data, uint16_t len, uint32_t* savedAt) {
+    if (!LittleFS.exists(path)) return false;
+
+    File f = LittleFS.open(path, FILE_READ);
+    if (!f) return false;
+
+    RecordHeader hdr;
+    bool ok = f.read((uint8_t*)&hdr, sizeof(hdr)) == sizeof(hdr) &&
+              hdr.magic == RECORD_MAGIC && hdr.len == len &&
+              f.read((uint8_t*)data, len) == len;
+    f.close();
+
+    if (!ok || crc16((const uint8_t*)data, len) != hdr.crc) {
+        return false;
+    }
+
+    if (savedAt) *savedAt = hdr.savedAt;
+    return true;
+}
+
+void DataStore::remove(const char* key) {
+    if (!mounted) return;
+    char path[40];
+    makePath(key, path, sizeof(path), false);
+    LittleFS.remove(path);
+    // Or load() would fall back to it
+    makePath(key, path, sizeof(path), true);
+    LittleFS.remove(path);
+}
+
+void DataStore::formatAge(uint32_t savedAt, char* buf, size_t len) {
+    time_t now = time(nullptr);
+    if (savedAt == 0 || now < (time_t)MIN_VALID_EPOCH || (uint32_t)now < savedAt) {
+        snprintf(buf, len, "cached");
+        return;
+    }
+
+    uint32_t age = (uint32_t)now - savedAt;
+    if (age < 60) {
+        snprintf(buf, len, "%lus ago", (unsigned long)age);
+    } else if (age < 3600) {
+        snprintf(buf, len, "%lum ago", (unsigned long)(age / 60));
+    } else if (age < 86400) {
+        snprintf(buf, len, "%luh ago", (unsigned long)(age / 3600));
+    } else {
+        snprintf(buf, len, "%lud ago", (unsigned long)(age / 86400));
+    }
+}
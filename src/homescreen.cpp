@@ -2,6 +2,7 @@
 #include "ui.h"
 #include "config.h"
 #include "wifi_manager.h"
+#include "data_store.h"
 #include <WiFi.h>
 #include <time.h>
 #include <ArduinoJson.h>
@@ -28,6 +29,11 @@ static char weatherDesc[16] = "";
 static unsigned long lastWeatherFetch = 0;
 static const unsigned long WEATHER_FETCH_INTERVAL = 1800000; // 30 minutes
 
+struct HomeWeatherRecord {
+    char temp[8];
+    char desc[16];
+};
+
 // Days of week
 static const char* daysOfWeek[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
 static const char* months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", 
@@ -45,6 +51,13 @@ void Homescreen::loadTimeSettings() {
 void Homescreen::init() {
     // Load time settings; defer NTP + weather until WiFi is up (handled in update())
     loadTimeSettings();
+
+    // Show the last weather we saw until the first fetch lands
+    HomeWeatherRecord rec;
+    if (DataStore::load("home_wx", &rec, sizeof(rec))) {
+        memcpy(weatherTemp, rec.temp, sizeof(weatherTemp));
+        memcpy(weatherDesc, rec.desc, sizeof(weatherDesc));
+    }
 }
 
 void Homescreen::syncTime() {
@@ -73,7 +86,7 @@ void Homescreen::syncTime() {
 }
 
 void Homescreen::fetchWeather() {
-    if (!WiFiManager::isConnected()) return;
+    if (!WiFiManager::canFetch()) return;
     
     char url[200];
     snprintf(url, sizeof(url), 
@@ -93,6 +106,11 @@ void Homescreen::fetchWeather() {
             snprintf(weatherTemp, sizeof(weatherTemp), "%.0f", temp);
             strncpy(weatherDesc, desc, sizeof(weatherDesc) - 1);
             lastWeatherFetch = millis();
+
+            HomeWeatherRecord rec;
+            memcpy(rec.temp, weatherTemp, sizeof(rec.temp));
+            memcpy(rec.desc, weatherDesc, sizeof(rec.desc));
+            DataStore::save("home_wx", &rec, sizeof(rec));
             
             Serial.printf("Weather: %s°C %s\n", weatherTemp, weatherDesc);
         }
@@ -0,0 +1,149 @@
+#include "http_fixtures.h"
+#include "config.h"
+#include "data_store.h"
+#include <LittleFS.h>
+
+uint32_t HttpFixtures::recorded = 0;
+uint32_t HttpFixtures::replayed = 0;
+uint32_t HttpFixtures::missing = 0;
+uint32_t HttpFixtures::injected = 0;
+uint32_t HttpFixtures::rngState = HTTP_FIXTURE_SEED;
+
+// What an injected failure looks like to the caller (HTTPC_ERROR_READ_TIMEOUT)
+static const int INJECTED_FAILURE_CODE = -11;
+
+void HttpFixtures::init() {
+    if (HTTP_FIXTURE_MODE == HTTP_FIXTURE_OFF) return;
+
+    if (!DataStore::isMounted()) {
+        Serial.println("FX: LittleFS not mounted, fixtures disabled");
+        return;
+    }
+    if (!LittleFS.exists("/fx")) {
+        LittleFS.mkdir("/fx");
+    }
+    Serial.printf("FX: %s mode, latency %dms, failures %d%%\n",
+                  isRecording() ? "record" : "replay",
+                  HTTP_FIXTURE_LATENCY_MS, HTTP_FIXTURE_FAIL_PCT);
+}
+
+bool HttpFixtures::isRecording() {
+    return HTTP_FIXTURE_MODE == HTTP_FIXTURE_RECORD && DataStore::isMounted();
+}
+
+bool HttpFixtures::isReplaying() {
+    return HTTP_FIXTURE_MODE == HTTP_FIXTURE_REPLAY;
+}
+
+void HttpFixtures::makePath(const char* url, char* path, size_t len, bool temp) {
+    // FNV-1a of the full URL; the URL is stored in the file to catch collisions
+    uint32_t hash = 2166136261u;
+    for (const char* p = url; *p; p++) {
+        hash ^= (uint8_t)*p;
+        hash *= 16777619u;
+    }
+    snprintf(path, len, "/fx/%08lx%s", (unsigned long)hash, temp ? ".tmp" : ".txt");
+}
+
+uint32_t HttpFixtures::nextRandom() {
+    // xorshift32: the same seed gives the same failure pattern every run
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+bool HttpFixtures::replay(const char* url, String& payload, int& status) {
+    if (HTTP_FIXTURE_LATENCY_MS > 0) {
+        delay(HTTP_FIXTURE_LATENCY_MS);
+    }
+
+    if (HTTP_FIXTURE_FAIL_PCT > 0 && (int)(nextRandom() % 100) < HTTP_FIXTURE_FAIL_PCT) {
+        injected++;
+        payload = "";
+        status = INJECTED_FAILURE_CODE;
+        return true;
+    }
+
+    if (HTTP_FIXTURE_BASE_URL[0]) return false;
+
+    char path[24];
+    makePath(url, path, sizeof(path), false);
+    File f = DataStore::isMounted() ? LittleFS.open(path, FILE_READ) : File();
+    if (!f) {
+        missing++;
+        Serial.printf("FX: no fixture for %s\n", url);
+        payload = "";
+        status = 404;
+        return true;
+    }
+
+    String statusLine = f.readStringUntil('\n');
+    String storedUrl = f.readStringUntil('\n');
+    if (storedUrl != url) {
+        f.close();
+        missing++;
+        Serial.printf("FX: hash collision for %s\n", url);
+        payload = "";
+        status = 404;
+        return true;
+    }
+
+    status = statusLine.toInt();
+    payload = f.readString();
+    f.close();
+    replayed++;
+    return true;
+}
+
+void HttpFixtures::record(const char* url, int status, const String& payload) {
+    if (!isRecording()) return;
+    // Failures are for HTTP_FIXTURE_FAIL_PCT to inject
+    if (status != 200 || payload.length() == 0) return;
+
+    char tmpPath[24], path[24];
+    makePath(url, tmpPath, sizeof(tmpPath), true);
+    makePath(url, path, sizeof(path), false);
+
+    File f = LittleFS.open(tmpPath, FILE_WRITE);
+    if (!f) return;
+
+    f.printf("%d\n%s\n", status, url);
+    bool ok = f.write((const uint8_t*)payload.c_str(), payload.length()) == payload.length();
+    f.close();
+
+    if (!ok) {
+        LittleFS.remove(tmpPath);
+        return;
+    }
+    // rename replaces the old fixture atomically
+    if (LittleFS.rename(tmpPath, path)) {
+        recorded++;
+        Serial.printf("FX: recorded %s -> %s (%d, %u bytes)\n", url, path, status, payload.length());
+    }
+}
+
+bool HttpFixtures::rewriteUrl(const char* url, char* out, size_t len) {
+    if (!isReplaying() || !HTTP_FIXTURE_BASE_URL[0]) return false;
+
+    const char* rest = strstr(url, "://");
+    rest = rest ? rest + 3 : url;
+    snprintf(out, len, "%s/%s", HTTP_FIXTURE_BASE_URL, rest);
+    return true;
+}
+
+uint32_t HttpFixtures::getRecordedCount() {
+    return recorded;
+}
+
+uint32_t HttpFixtures::getReplayedCount() {
+    return replayed;
+}
+
+uint32_t HttpFixtures::getMissingCount() {
+    return missing;
+}
+
+uint32_t HttpFixtures::getInjectedFailures() {
+    return injected;
+}
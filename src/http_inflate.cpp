@@ -0,0 +1,187 @@
+#include "http_inflate.h"
+#include <esp32/rom/miniz.h>
+#include <esp_rom_crc.h>
+#include <esp_heap_caps.h>
+
+// Buffered view of the response body
+struct InflateInput {
+    Client* client;
+    int remaining;      // Body bytes still to read, -1 = until close
+    uint32_t wire;
+    size_t pos;
+    size_t len;
+    uint8_t buf[HTTP_INFLATE_IN_CHUNK];
+};
+
+// Refill the buffer; false at the end of the body or on a stall
+static bool fillInput(InflateInput& in) {
+    in.pos = 0;
+    in.len = 0;
+    unsigned long start = millis();
+    while (in.remaining != 0) {
+        int avail = in.client->available();
+        if (avail > 0) {
+            size_t want = min((size_t)avail, sizeof(in.buf));
+            if (in.remaining > 0) want = min(want, (size_t)in.remaining);
+            int n = in.client->read(in.buf, want);
+            if (n > 0) {
+                in.len = n;
+                in.wire += n;
+                if (in.remaining > 0) in.remaining -= n;
+                return true;
+            }
+        } else if (!in.client->connected()) {
+            return false;
+        }
+        if (millis() - start > HTTP_INFLATE_TIMEOUT_MS) return false;
+        delay(1);
+    }
+    return false;
+}
+
+static int nextByte(InflateInput& in) {
+    if (in.pos == in.len && !fillInput(in)) return -1;
+    return in.buf[in.pos++];
+}
+
+static bool skipBytes(InflateInput& in, size_t count) {
+    while (count--) {
+        if (nextByte(in) < 0) return false;
+    }
+    return true;
+}
+
+static bool skipString(InflateInput& in) {
+    int c;
+    do {
+        c = nextByte(in);
+    } while (c > 0);
+    return c == 0;
+}
+
+// RFC 1952 member header: magic, method, flags, then optional fields
+static bool skipGzipHeader(InflateInput& in) {
+    uint8_t head[10];
+    for (int i = 0; i < 10; i++) {
+        int c = nextByte(in);
+        if (c < 0) return false;
+        head[i] = c;
+    }
+    if (head[0] != 0x1f || head[1] != 0x8b || head[2] != 8) return false;
+
+    uint8_t flags = head[3];
+    if (flags & 0x04) {  // FEXTRA
+        int lo = nextByte(in);
+        int hi = nextByte(in);
+        if (lo < 0 || hi < 0 || !skipBytes(in, lo | (hi << 8))) return false;
+    }
+    if ((flags & 0x08) && !skipString(in)) return false;   // FNAME
+    if ((flags & 0x10) && !skipString(in)) return false;   // FCOMMENT
+    if ((flags & 0x02) && !skipBytes(in, 2)) return false; // FHCRC
+    return true;
+}
+
+static uint32_t readLe32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static bool inflateBody(InflateInput& in, HttpInflate::Format format, String& out,
+                        tinfl_decompressor* inflator, uint8_t* window) {
+    bool gzip = format == HttpInflate::Format::GZIP;
+    if (gzip && !skipGzipHeader(in)) return false;
+
+    // zlib streams carry their own header and Adler-32, checked by tinfl
+    uint32_t flags = gzip ? 0 : TINFL_FLAG_PARSE_ZLIB_HEADER;
+    tinfl_init(inflator);
+
+    size_t windowPos = 0;
+    uint32_t produced = 0;
+    uint32_t crc = 0;
+    bool eof = false;
+
+    while (true) {
+        if (in.pos == in.len && !eof) eof = !fillInput(in);
+
+        size_t inSize = in.len - in.pos;
+        size_t outSize = TINFL_LZ_DICT_SIZE - windowPos;
+        tinfl_status status = tinfl_decompress(inflator, in.buf + in.pos, &inSize,
+            window, window + windowPos, &outSize,
+            flags | (eof ? 0 : TINFL_FLAG_HAS_MORE_INPUT));
+        in.pos += inSize;
+
+        if (outSize > 0) {
+            produced += outSize;
+            if (produced > HTTP_INFLATE_MAX_OUT) return false;
+            if (!out.concat((const char*)window + windowPos, outSize)) return false;
+            if (gzip) crc = esp_rom_crc32_le(crc, window + windowPos, outSize);
+            windowPos = (windowPos + outSize) & (TINFL_LZ_DICT_SIZE - 1);
+        }
+
+        if (status == TINFL_STATUS_DONE) break;
+        if (status < 0) return false;
+        if (status == TINFL_STATUS_NEEDS_MORE_INPUT && eof) return false;
+    }
+
+    if (gzip) {
+        // Trailer: CRC-32 and length of the decoded data. The ROM tinfl
+        // doesn't give back the bytes it read ahead into its bit buffer,
+        // and they may come from an earlier read, so take them from there.
+        uint8_t trailer[8];
+        size_t have = 0;
+        uint32_t bits = inflator->m_num_bits;
+        tinfl_bit_buf_t ahead = inflator->m_bit_buf >> (bits & 7);
+        for (; bits >= 8 && have < sizeof(trailer); bits -= 8) {
+            trailer[have++] = ahead & 0xff;
+            ahead >>= 8;
+        }
+        while (have < sizeof(trailer)) {
+            int c = nextByte(in);
+            if (c < 0) return false;
+            trailer[have++] = c;
+        }
+        if (readLe32(trailer) != crc || readLe32(trailer + 4) != produced) return false;
+    }
+    return true;
+}
+
+HttpInflate::Format HttpInflate::parseEncoding(const String& encoding) {
+    if (encoding.equalsIgnoreCase("gzip") || encoding.equalsIgnoreCase("x-gzip")) {
+        return Format::GZIP;
+    }
+    if (encoding.equalsIgnoreCase("deflate")) {
+        return Format::ZLIB;
+    }
+    return Format::NONE;
+}
+
+bool HttpInflate::hasMemory() {
+    size_t need = TINFL_LZ_DICT_SIZE + sizeof(tinfl_decompressor) + sizeof(InflateInput);
+    return heap_caps_get_largest_free_block(MALLOC_CAP_8BIT) >= TINFL_LZ_DICT_SIZE &&
+           heap_caps_get_free_size(MALLOC_CAP_8BIT) >= need + HTTP_INFLATE_HEAP_RESERVE;
+}
+
+HttpInflate::Result HttpInflate::decode(Client& in, int contentLength, Format format,
+                                        String& out, uint32_t& wireBytes) {
+    InflateInput* input = (InflateInput*)malloc(sizeof(InflateInput));
+    tinfl_decompressor* inflator = (tinfl_decompressor*)malloc(sizeof(tinfl_decompressor));
+    uint8_t* window = (uint8_t*)malloc(TINFL_LZ_DICT_SIZE);
+
+    Result result = Result::NO_MEMORY;
+    if (input && inflator && window) {
+        input->client = &in;
+        input->remaining = contentLength;
+        input->wire = 0;
+        input->pos = 0;
+        input->len = 0;
+        bool ok = inflateBody(*input, format, out, inflator, window);
+        wireBytes = input->wire;
+        result = ok ? Result::OK : Result::FAILED;
+    } else {
+        Serial.println("HTTP: no memory to inflate");
+    }
+
+    free(window);
+    free(inflator);
+    free(input);
+    return result;
+}
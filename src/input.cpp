@@ -2,6 +2,7 @@
 #include <Preferences.h>
 #include <esp_sleep.h>
 #include <driver/gpio.h>
+#include <esp_timer.h>
 
 bool Input::currentState[NUM_BUTTONS] = {false};
 bool Input::previousState[NUM_BUTTONS] = {false};
@@ -9,6 +10,8 @@ unsigned long Input::lastDebounce[NUM_BUTTONS] = {0};
 unsigned long Input::lastActivity = 0;
 int Input::sleepTimeoutIndex = 0;
 bool Input::skipNextCallback = false;
+uint32_t Input::sleepCount = 0;
+volatile int64_t Input::wakeAlarmAt = 0;
 Input::ButtonCallback Input::callback = nullptr;
 
 const uint8_t Input::buttonPins[NUM_BUTTONS] = {
@@ -101,6 +104,10 @@ unsigned long Input::getSleepTimeoutMs() {
     return sleepTimeouts[sleepTimeoutIndex];
 }
 
+uint32_t Input::getSleepCount() {
+    return sleepCount;
+}
+
 void Input::loadSleepTimeout() {
     Preferences prefs;
     prefs.begin(NVS_NAMESPACE, true);
@@ -125,15 +132,28 @@ void Input::enterSleep() {
     }
     esp_sleep_enable_gpio_wakeup();
 
+    // A deadline already passed has rung or is ringing; don't wake for it
+    int64_t alarmAt = wakeAlarmAt;
+    int64_t alarmIn = alarmAt - esp_timer_get_time();
+    bool wakeForAlarm = alarmAt && alarmIn > 0;
+    if (wakeForAlarm) esp_sleep_enable_timer_wakeup(alarmIn);
+
     // Enter light sleep (preserves state, no reboot)
+    sleepCount++;
     esp_light_sleep_start();
+    bool byAlarm = esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER;
 
     // Disable all wakeup sources after wake
     for (int i = 0; i < NUM_BUTTONS; i++) {
         gpio_wakeup_disable((gpio_num_t)buttonPins[i]);
     }
+    if (wakeForAlarm) esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_TIMER);
 
     // Skip next button callback (the wake press)
-    skipNextCallback = true;
+    skipNextCallback = !byAlarm;
     lastActivity = millis();
 }
+
+void Input::setWakeAlarm(int64_t atUs) {
+    wakeAlarmAt = atUs;
+}
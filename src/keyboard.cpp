@@ -1,6 +1,7 @@
 #include "keyboard.h"
 #include "ui.h"
 #include "input.h"
+#include "text_cache.h"
 
 bool Keyboard::active = false;
 bool Keyboard::confirmed = false;
@@ -37,6 +38,24 @@ static const int numRows = 4;
 // Right column action labels
 static const char* actionLabels[] = {"CAP", "SPC", "OK", "DEL"};
 
+// Key grid geometry
+static const int charStartX = 4;  // Left margin for characters
+static const int keyPitch = 10;
+static const int actionX = 106;
+static const int actionWidth = 20;
+
+// Text cache raster for one keyboard row. Key: the row's characters as
+// shown, a tab, the action label.
+static void drawKeyRow(int x, int baseline, const char* key) {
+    char str[2] = {0, 0};
+    int col = 0;
+    for (; *key && *key != '\t'; key++) {
+        str[0] = *key;
+        u8g2.drawStr(x + col++ * keyPitch, baseline, str);
+    }
+    if (*key == '\t') u8g2.drawStr(x + actionX - charStartX, baseline, key + 1);
+}
+
 void Keyboard::init() {
     active = false;
     confirmed = false;
@@ -77,7 +96,7 @@ void Keyboard::render() {
 
     // Draw prompt and input
     UI::setSmallFont();
-    u8g2.drawStr(2, 8, prompt);
+    TextCache::drawStr(2, 8, prompt);
 
     // Input box
     u8g2.drawFrame(0, 10, 100, 12);
@@ -94,52 +113,16 @@ void Keyboard::render() {
 
     int startY = 26;
     int rowHeight = 9;
-    int charStartX = 4;  // Left margin for characters
 
-    // Draw character rows
+    // Each row, characters and action button, is one cached strip; the
+    // cursor is drawn over it
     for (int row = 0; row < numRows; row++) {
         int y = startY + row * rowHeight;
         int len = rowLengths[row];
 
-        for (int col = 0; col < len; col++) {
-            int x = charStartX + col * 10;
-            char c = layout[row][col];
-
-            if (capsLock && c >= 'a' && c <= 'z') {
-                c = c - 'a' + 'A';
-            }
-
-            char str[2] = {c, '\0'};
-
-            // Highlight selected character
-            if (!inActionColumn && row == cursorY && col == cursorX) {
-                u8g2.drawBox(x - 1, y - 6, 9, 8);
-                u8g2.setDrawColor(0);
-                u8g2.drawStr(x, y, str);
-                u8g2.setDrawColor(1);
-            } else {
-                u8g2.drawStr(x, y, str);
-            }
-        }
-    }
-
-    // Draw right action column
-    int actionX = 106;
-    int actionWidth = 20;
-
-    for (int i = 0; i < numRows; i++) {
-        int y = startY + i * rowHeight;
-        bool selected = inActionColumn && (cursorY == i);
-
-        // Draw action button
-        if (selected) {
-            u8g2.drawBox(actionX - 1, y - 6, actionWidth, 8);
-            u8g2.setDrawColor(0);
-        }
-
         // Show appropriate label
-        const char* label = actionLabels[i];
-        if (i == 0) {
+        const char* label = actionLabels[row];
+        if (row == 0) {
             // CAP button - show mode
             if (symbolMode) {
                 label = "ABC";
@@ -148,16 +131,39 @@ void Keyboard::render() {
             }
         }
 
-        u8g2.drawStr(actionX, y, label);
+        char key[TEXT_CACHE_KEY_LEN];
+        for (int col = 0; col < len; col++) {
+            char c = layout[row][col];
+            if (capsLock && c >= 'a' && c <= 'z') {
+                c = c - 'a' + 'A';
+            }
+            key[col] = c;
+        }
+        key[len] = '\t';
+        strcpy(key + len + 1, label);
+        TextCache::draw(charStartX, y, key, drawKeyRow, actionX - charStartX + actionWidth);
 
-        if (selected) u8g2.setDrawColor(1);
+        if (row != cursorY) continue;
+        if (inActionColumn) {
+            u8g2.drawBox(actionX - 1, y - 6, actionWidth, 8);
+            u8g2.setDrawColor(0);
+            u8g2.drawStr(actionX, y, label);
+        } else {
+            // Highlight selected character
+            int x = charStartX + cursorX * keyPitch;
+            char str[2] = {key[cursorX], '\0'};
+            u8g2.drawBox(x - 1, y - 6, 9, 8);
+            u8g2.setDrawColor(0);
+            u8g2.drawStr(x, y, str);
+        }
+        u8g2.setDrawColor(1);
     }
 
     // Draw separator line between chars and actions
     u8g2.drawVLine(102, startY - 6, numRows * rowHeight);
 
     // Status hints at bottom
-    u8g2.drawStr(2, 63, "A:sel B:back C:mode D:exit");
+    TextCache::drawStr(2, 63, "A:sel B:back C:mode D:exit");
 
     UI::flush();
 }
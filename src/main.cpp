@@ -1,3 +1,7 @@
+// Unit tests (pio test) build the other modules with their own setup()
+// and loop()
+#ifndef PIO_UNIT_TESTING
+
 #include <Arduino.h>
 #include <Wire.h>
 #include "soc/soc.h"
@@ -10,6 +14,11 @@
 #include "keyboard.h"
 #include "wifi_manager.h"
 #include "homescreen.h"
+#include "data_store.h"
+#include "http_fixtures.h"
+#include "web_service.h"
+#include "metrics.h"
+#include "audio.h"
 
 // App includes
 #include "apps/launcher.h"
@@ -71,6 +80,27 @@ const int appCount = sizeof(apps) / sizeof(apps[0]);
 AppState currentState = AppState::HOMESCREEN;
 App* currentApp = nullptr;
 
+// Metrics: time spent in loop() work, and per-app usage
+static Histogram loopHistogram;
+static const float LOOP_BUCKETS_MS[] = {1, 2, 5, 10, 20, 50, 100, 250, 500, 1000};
+static unsigned long appUsageMs[appCount] = {0};
+static uint32_t appOpens[appCount] = {0};
+static int currentAppIndex = -1;
+static unsigned long appOpenedAt = 0;
+
+static void writeAppMetrics(Print& out) {
+    Metrics::writeFamily(out, "app_usage_seconds_total", "Time spent in each app", "counter");
+    for (int i = 0; i < appCount; i++) {
+        unsigned long ms = appUsageMs[i];
+        if (i == currentAppIndex) ms += millis() - appOpenedAt;
+        Metrics::writeSample(out, "app_usage_seconds_total", "app", apps[i]->getName(), ms / 1000.0);
+    }
+    Metrics::writeFamily(out, "app_opens_total", "Times each app was launched", "counter");
+    for (int i = 0; i < appCount; i++) {
+        Metrics::writeSample(out, "app_opens_total", "app", apps[i]->getName(), appOpens[i]);
+    }
+}
+
 // Boot animation helper
 void showBootProgress(int percent, const char* status) {
     UI::clear();
@@ -112,6 +142,9 @@ void onButtonEvent(uint8_t btn, bool pressed) {
             int idx = launcher.getSelectedApp();
             if (idx >= 0 && idx < appCount) {
                 currentApp = apps[idx];
+                currentAppIndex = idx;
+                appOpens[idx]++;
+                appOpenedAt = millis();
                 currentApp->init();
                 currentState = AppState::APP_RUNNING;
             }
@@ -124,6 +157,8 @@ void onButtonEvent(uint8_t btn, bool pressed) {
             currentApp->wantsToExit = false;
             currentApp->onClose();
             currentApp = nullptr;
+            appUsageMs[currentAppIndex] += millis() - appOpenedAt;
+            currentAppIndex = -1;
             currentState = AppState::LAUNCHER;
         }
     }
@@ -158,6 +193,11 @@ void setup() {
     showBootProgress(40, "Keyboard ready");
     delay(100);
 
+    // Mount LittleFS for last-known-good app data
+    DataStore::init();
+    HttpFixtures::init();
+    showBootProgress(45, "Storage ready");
+
     // Initialize WiFi (auto-connect runs asynchronously in loop())
     WiFiManager::init();
     showBootProgress(50, "Starting WiFi...");
@@ -165,6 +205,19 @@ void setup() {
     showBootProgress(80, "WiFi: background");
     delay(100);
 
+    // Shared web server; listens once WiFi is up
+    WebService::init();
+    OTAApp::registerRoutes();
+    PongApp::registerRoutes();
+
+    // /metrics for fleet monitoring
+    Metrics::init();
+    Metrics::addHistogram("loop_duration_ms", "Work done per loop() pass", &loopHistogram,
+                          LOOP_BUCKETS_MS, sizeof(LOOP_BUCKETS_MS) / sizeof(LOOP_BUCKETS_MS[0]));
+    Metrics::addCollector(writeAppMetrics);
+    Metrics::addCounter("audio_dropped_total", "Sounds skipped for a more important one",
+                        []() -> double { return Audio::getDroppedCount(); });
+
     // Initialize homescreen
     showBootProgress(90, "Loading homescreen...");
     Homescreen::init();
@@ -176,20 +229,23 @@ void setup() {
     delay(300);
 
     // Startup beeps
-    UI::beep(1000, 50);
-    delay(100);
-    UI::beep(1500, 50);
+    Audio::play(BOOT_JINGLE, AUDIO_PRIO_MUSIC);
 
     Serial.println("Ready!");
 }
 
 void loop() {
+    unsigned long loopStart = micros();
+
     // Update input
     Input::update();
 
     // Progress async WiFi connect state machine
     WiFiManager::update();
 
+    // Start the web server on connect, socket cleanup, deferred restart
+    WebService::update();
+
     // Check for sleep timeout
     unsigned long sleepMs = Input::getSleepTimeoutMs();
     if (sleepMs > 0) {
@@ -201,6 +257,7 @@ void loop() {
             Input::enterSleep();
             // Continues here after wake from light sleep
             u8g2.setPowerSave(0);
+            loopStart = micros();
         }
     }
 
@@ -208,6 +265,7 @@ void loop() {
     if (Keyboard::isActive()) {
         Keyboard::update();
         Keyboard::render();
+        Metrics::observe(loopHistogram, (micros() - loopStart) / 1000.0f);
         return;
     }
 
@@ -223,6 +281,14 @@ void loop() {
         currentApp->render();
     }
 
+    Metrics::observe(loopHistogram, (micros() - loopStart) / 1000.0f);
+
     // Small delay to prevent hogging CPU
-    delay(10);
+    if (currentState == AppState::APP_RUNNING && currentApp && currentApp->wantsFullSpeed) {
+        yield();
+    } else {
+        delay(10);
+    }
 }
+
+#endif
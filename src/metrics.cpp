@@ -0,0 +1,209 @@
+#include "metrics.h"
+#include "web_service.h"
+#include "wifi_manager.h"
+#include "input.h"
+#include "text_cache.h"
+
+Metrics::Entry Metrics::entries[METRICS_MAX];
+int Metrics::entryCount = 0;
+MetricCollector Metrics::collectors[METRICS_MAX_COLLECTORS];
+int Metrics::collectorCount = 0;
+
+void Metrics::init() {
+    addGauge("uptime_seconds", "Time since boot",
+             []() -> double { return millis() / 1000; });
+    addGauge("heap_free_bytes", "Free heap",
+             []() -> double { return ESP.getFreeHeap(); });
+    addGauge("heap_min_free_bytes", "Lowest free heap since boot",
+             []() -> double { return ESP.getMinFreeHeap(); });
+    addGauge("heap_largest_free_block_bytes", "Largest allocatable block",
+             []() -> double { return ESP.getMaxAllocHeap(); });
+
+    addGauge("wifi_connected", "1 while associated with an access point",
+             []() -> double { return WiFiManager::isConnected() ? 1 : 0; });
+    addGauge("wifi_rssi_dbm", "Signal strength of the current network",
+             []() -> double { return WiFiManager::isConnected() ? WiFiManager::getRSSI() : 0; });
+    addCounter("wifi_connects_total", "Successful connects since boot",
+               []() -> double { return WiFiManager::getConnectCount(); });
+    addCounter("wifi_drops_total", "Connections lost and reconnected automatically",
+               []() -> double { return WiFiManager::getDropCount(); });
+
+    addCounter("sleeps_total", "Light sleep entries",
+               []() -> double { return Input::getSleepCount(); });
+
+    addCounter("dns_cache_hits_total", "Lookups answered from the DNS cache",
+               []() -> double { return WiFiManager::getDnsStats().hits; });
+    addCounter("dns_cache_misses_total", "Lookups sent to the DNS server",
+               []() -> double { return WiFiManager::getDnsStats().misses; });
+
+    addCounter("ui_text_cache_hits_total", "Title, status bar and keyboard text blitted from the cache",
+               []() -> double { return TextCache::getHits(); });
+    addCounter("ui_text_cache_misses_total", "Text rasterized into the cache",
+               []() -> double { return TextCache::getMisses(); });
+    addGauge("ui_text_cache_bytes", "Bitmap memory held by the text cache",
+             []() -> double { return TextCache::getBytesUsed(); });
+
+    addCounter("web_requests_total", "Requests served by the device web server",
+               []() -> double { return WebService::getRequestCount(); });
+    addCounter("web_rejected_total", "Requests answered 503 because the server was busy",
+               []() -> double { return WebService::getRejectedCount(); });
+
+    addCollector(writeHosts);
+
+    WebService::on("/metrics", HTTP_GET, [](AsyncWebServerRequest* request) {
+        AsyncResponseStream* response = request->beginResponseStream("text/plain; version=0.0.4");
+        writeText(*response);
+        request->send(response);
+    });
+}
+
+bool Metrics::add(const char* name, const char* help, Type type,
+                  MetricReader read, Histogram* h) {
+    if (entryCount >= METRICS_MAX) {
+        Serial.printf("Metrics: registry full, %s dropped\n", name);
+        return false;
+    }
+    Entry& e = entries[entryCount++];
+    e.name = name;
+    e.help = help;
+    e.type = type;
+    e.read = read;
+    e.histogram = h;
+    return true;
+}
+
+void Metrics::addCounter(const char* name, const char* help, MetricReader read) {
+    add(name, help, Type::COUNTER, read, nullptr);
+}
+
+void Metrics::addGauge(const char* name, const char* help, MetricReader read) {
+    add(name, help, Type::GAUGE, read, nullptr);
+}
+
+void Metrics::addHistogram(const char* name, const char* help, Histogram* h,
+                           const float* bounds, uint8_t boundCount) {
+    memset(h, 0, sizeof(Histogram));
+    h->bounds = bounds;
+    h->boundCount = min(boundCount, (uint8_t)METRICS_MAX_BUCKETS);
+    add(name, help, Type::HISTOGRAM, nullptr, h);
+}
+
+void Metrics::addCollector(MetricCollector collect) {
+    if (collectorCount < METRICS_MAX_COLLECTORS) {
+        collectors[collectorCount++] = collect;
+    }
+}
+
+void Metrics::observe(Histogram& h, float value) {
+    int i = 0;
+    while (i < h.boundCount && value > h.bounds[i]) i++;
+    h.buckets[i]++;
+    h.count++;
+    h.sum += value;
+}
+
+void Metrics::writeFamily(Print& out, const char* name, const char* help, const char* type) {
+    out.printf("# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+void Metrics::writeSample(Print& out, const char* name, const char* label,
+                          const char* labelValue, double value) {
+    out.print(name);
+    if (label) {
+        out.printf("{%s=\"", label);
+        for (const char* c = labelValue; *c; c++) {
+            if (*c == '"' || *c == '\\') out.print('\\');
+            if (*c == '\n') {
+                out.print("\\n");
+                continue;
+            }
+            out.print(*c);
+        }
+        out.print("\"}");
+    }
+    out.printf(" %.10g\n", value);
+}
+
+// Runs on the web server task. Values are read without locking, so a
+// scrape can catch a request half-recorded; the next one is consistent.
+void Metrics::writeText(Print& out) {
+    for (int i = 0; i < entryCount; i++) {
+        const Entry& e = entries[i];
+        switch (e.type) {
+            case Type::COUNTER:
+                writeFamily(out, e.name, e.help, "counter");
+                writeSample(out, e.name, nullptr, nullptr, e.read());
+                break;
+            case Type::GAUGE:
+                writeFamily(out, e.name, e.help, "gauge");
+                writeSample(out, e.name, nullptr, nullptr, e.read());
+                break;
+            case Type::HISTOGRAM:
+                writeHistogram(out, e);
+                break;
+        }
+    }
+    for (int i = 0; i < collectorCount; i++) {
+        collectors[i](out);
+    }
+}
+
+void Metrics::writeHistogram(Print& out, const Entry& e) {
+    const Histogram& h = *e.histogram;
+    writeFamily(out, e.name, e.help, "histogram");
+
+    // Exposition buckets are cumulative
+    uint32_t cumulative = 0;
+    char le[16];
+    for (int i = 0; i <= h.boundCount; i++) {
+        cumulative += h.buckets[i];
+        if (i < h.boundCount) {
+            snprintf(le, sizeof(le), "%g", h.bounds[i]);
+        } else {
+            strcpy(le, "+Inf");
+        }
+        out.printf("%s_bucket{le=\"%s\"} %lu\n", e.name, le, (unsigned long)cumulative);
+    }
+    out.printf("%s_sum %.10g\n%s_count %lu\n", e.name, h.sum, e.name, (unsigned long)h.count);
+}
+
+// Per API host, from the WiFiManager telemetry
+void Metrics::writeHosts(Print& out) {
+    int n = WiFiManager::getHostCount();
+    if (n == 0) return;
+
+    writeFamily(out, "http_requests_total", "API requests sent", "counter");
+    for (int i = 0; i < n; i++) {
+        const HostHealth* h = WiFiManager::getHostHealth(i);
+        writeSample(out, "http_requests_total", "host", h->host, h->requests);
+    }
+    writeFamily(out, "http_failures_total", "Timeouts, connection errors, 5xx and 429", "counter");
+    for (int i = 0; i < n; i++) {
+        const HostHealth* h = WiFiManager::getHostHealth(i);
+        writeSample(out, "http_failures_total", "host", h->host, h->failures);
+    }
+    writeFamily(out, "http_rejected_total", "Requests failed fast by the circuit breaker", "counter");
+    for (int i = 0; i < n; i++) {
+        const HostHealth* h = WiFiManager::getHostHealth(i);
+        writeSample(out, "http_rejected_total", "host", h->host, h->rejected);
+    }
+    writeFamily(out, "http_wire_bytes_total", "Response body bytes received", "counter");
+    for (int i = 0; i < n; i++) {
+        const HostHealth* h = WiFiManager::getHostHealth(i);
+        writeSample(out, "http_wire_bytes_total", "host", h->host, h->wireBytes);
+    }
+
+    // DNS + connect + first byte + body, as a summary without quantiles
+    writeFamily(out, "http_request_duration_ms", "Request time", "summary");
+    for (int i = 0; i < n; i++) {
+        const HostHealth* h = WiFiManager::getHostHealth(i);
+        writeSample(out, "http_request_duration_ms_sum", "host", h->host,
+                    (double)h->dnsMs + h->connectMs + h->ttfbMs + h->bodyMs);
+        writeSample(out, "http_request_duration_ms_count", "host", h->host, h->requests);
+    }
+    writeFamily(out, "http_request_duration_max_ms", "Slowest request", "gauge");
+    for (int i = 0; i < n; i++) {
+        const HostHealth* h = WiFiManager::getHostHealth(i);
+        writeSample(out, "http_request_duration_max_ms", "host", h->host, h->maxTotalMs);
+    }
+}
@@ -0,0 +1,236 @@
+#include "text_cache.h"
+#include "ui.h"
+
+TextCache::Entry TextCache::entries[TEXT_CACHE_ENTRIES];
+uint32_t TextCache::pool[TEXT_CACHE_POOL_WORDS];
+uint16_t TextCache::poolUsed = 0;
+uint32_t TextCache::clock = 0;
+uint32_t TextCache::hits = 0;
+uint32_t TextCache::misses = 0;
+bool TextCache::enabled = true;
+
+// FNV-1a, so most lookups skip the strcmp
+static uint32_t hashKey(const char* key) {
+    uint32_t h = 2166136261UL;
+    while (*key) {
+        h ^= (uint8_t)*key++;
+        h *= 16777619UL;
+    }
+    return h;
+}
+
+void TextCache::drawStr(int x, int y, const char* text) {
+    Entry* e = enabled ? fetch(text, nullptr, -1) : nullptr;
+    if (!e || !blit(*e, x, y)) u8g2.drawStr(x, y, text);
+}
+
+int TextCache::getStrWidth(const char* text) {
+    Entry* e = enabled ? find(text, nullptr) : nullptr;
+    return e ? e->width : u8g2.getStrWidth(text);
+}
+
+void TextCache::draw(int x, int y, const char* key, TextRaster raster, int width) {
+    Entry* e = enabled ? fetch(key, raster, width) : nullptr;
+    if (!e || !blit(*e, x, y)) raster(x, y, key);
+}
+
+void TextCache::setEnabled(bool on) {
+    enabled = on;
+}
+
+uint32_t TextCache::getHits() {
+    return hits;
+}
+
+uint32_t TextCache::getMisses() {
+    return misses;
+}
+
+uint32_t TextCache::getBytesUsed() {
+    uint32_t words = 0;
+    for (const Entry& e : entries) {
+        if (e.used) words += footprint(e);
+    }
+    return words * sizeof(uint32_t);
+}
+
+// Pool words: ink, then coverage in solid mode
+int TextCache::footprint(const Entry& e) {
+    return e.solid ? 2 * e.width : e.width;
+}
+
+TextCache::Entry* TextCache::find(const char* key, TextRaster raster) {
+    u8g2_t* g = u8g2.getU8g2();
+    bool solid = !g->font_decode.is_transparent;
+    uint32_t hash = hashKey(key);
+    for (Entry& e : entries) {
+        if (e.used && e.hash == hash && e.font == g->font && e.raster == raster &&
+            e.solid == solid && strcmp(e.key, key) == 0) {
+            return &e;
+        }
+    }
+    return nullptr;
+}
+
+// Cached entry for key, rasterized now on a miss. Width < 0 measures the
+// text. Null if it can't be cached (too wide, too tall, key too long).
+TextCache::Entry* TextCache::fetch(const char* key, TextRaster raster, int width) {
+    if (!*key) return nullptr;
+
+    Entry* e = find(key, raster);
+    if (e) {
+        hits++;
+        e->lastUsed = ++clock;
+        return e;
+    }
+    misses++;
+    if (width < 0) width = u8g2.getStrWidth(key);
+    return add(key, raster, width);
+}
+
+TextCache::Entry* TextCache::add(const char* key, TextRaster raster, int width) {
+    u8g2_t* g = u8g2.getU8g2();
+    int height = g->font_info.max_char_height;
+    if (width <= 0 || width > SCREEN_WIDTH || height <= 0 || height > 32) return nullptr;
+    if (strlen(key) >= TEXT_CACHE_KEY_LEN) return nullptr;
+    bool solid = !g->font_decode.is_transparent;
+    if (!reserve(solid ? 2 * width : width)) return nullptr;
+
+    Entry* e = nullptr;
+    Entry* oldest = nullptr;
+    for (Entry& candidate : entries) {
+        if (!candidate.used) {
+            e = &candidate;
+            break;
+        }
+        if (!oldest || candidate.lastUsed < oldest->lastUsed) oldest = &candidate;
+    }
+    if (!e) {
+        e = oldest;
+        evict(*e);
+    }
+
+    e->font = g->font;
+    e->raster = raster;
+    e->hash = hashKey(key);
+    strcpy(e->key, key);
+    e->lastUsed = ++clock;
+    e->offset = poolUsed;
+    e->width = width;
+    e->height = height;
+    e->top = -(height + g->font_info.y_offset);
+    e->solid = solid;
+    e->used = true;
+    poolUsed += footprint(*e);
+
+    // Draw at the top left of the frame and read the columns back: over
+    // a cleared patch for the ink, and in solid mode over a set one, where
+    // the glyph backgrounds come out cleared. Then restore the frame.
+    int pages = (height + 7) / 8;
+    uint8_t* buf = u8g2.getBufferPtr();
+    uint8_t saved[4 * SCREEN_WIDTH];
+    memcpy(saved, buf, pages * SCREEN_WIDTH);
+
+    uint8_t color = g->draw_color;
+    u8g2.setDrawColor(1);
+    uint32_t* ink = pool + e->offset;
+    for (int pass = 0; pass < (solid ? 2 : 1); pass++) {
+        memset(buf, pass ? 0xFF : 0, pages * SCREEN_WIDTH);
+        if (raster) {
+            raster(0, -e->top, key);
+        } else {
+            u8g2.drawStr(0, -e->top, key);
+        }
+        for (int c = 0; c < width; c++) {
+            uint32_t v = 0;
+            for (int p = 0; p < pages; p++) {
+                v |= (uint32_t)buf[p * SCREEN_WIDTH + c] << (8 * p);
+            }
+            // Second pass: covered = ink or cleared
+            if (pass) {
+                uint32_t rows = height < 32 ? (1UL << height) - 1 : 0xFFFFFFFF;
+                v = ink[c] | (~v & rows);
+            }
+            ink[pass * width + c] = v;
+        }
+    }
+    u8g2.setDrawColor(color);
+    memcpy(buf, saved, pages * SCREEN_WIDTH);
+    return e;
+}
+
+// Makes room for words at the end of the pool, evicting the least
+// recently used entries and closing the gaps they leave
+bool TextCache::reserve(int words) {
+    if (words > TEXT_CACHE_POOL_WORDS) return false;
+
+    while (poolUsed + words > TEXT_CACHE_POOL_WORDS) {
+        if (getBytesUsed() / sizeof(uint32_t) + words <= TEXT_CACHE_POOL_WORDS) {
+            compact();
+            continue;
+        }
+        Entry* oldest = nullptr;
+        for (Entry& e : entries) {
+            if (e.used && (!oldest || e.lastUsed < oldest->lastUsed)) oldest = &e;
+        }
+        if (!oldest) return false;
+        evict(*oldest);
+    }
+    return true;
+}
+
+void TextCache::evict(Entry& e) {
+    e.used = false;
+    if (e.offset + footprint(e) == poolUsed) poolUsed = e.offset;
+}
+
+// Slides entries down in pool order. Only runs on a miss with a full pool.
+void TextCache::compact() {
+    uint16_t next = 0;
+    while (true) {
+        Entry* lowest = nullptr;
+        for (Entry& e : entries) {
+            if (e.used && e.offset >= next && (!lowest || e.offset < lowest->offset)) {
+                lowest = &e;
+            }
+        }
+        if (!lowest) break;
+        memmove(pool + next, pool + lowest->offset, footprint(*lowest) * sizeof(uint32_t));
+        lowest->offset = next;
+        next += footprint(*lowest);
+    }
+    poolUsed = next;
+}
+
+// One shifted word per column into the page buffer (8 rows per byte,
+// LSB on top). Covered pixels take the ink, or in colour 0 its inverse,
+// the way u8g2 swaps foreground and background. False if it has to be
+// drawn the normal way.
+bool TextCache::blit(const Entry& e, int x, int y) {
+    uint8_t color = u8g2.getU8g2()->draw_color;
+    int top = y + e.top;
+    if (color > 1 || x < 0 || x >= SCREEN_WIDTH || top < 0 || top >= SCREEN_HEIGHT) {
+        return false;
+    }
+
+    uint8_t* buf = u8g2.getBufferPtr();
+    int firstPage = top >> 3;
+    int shift = top & 7;
+    int width = min((int)e.width, SCREEN_WIDTH - x);
+    const uint32_t* ink = pool + e.offset;
+    const uint32_t* cover = e.solid ? ink + e.width : ink;
+
+    for (int c = 0; c < width; c++) {
+        uint64_t v = (uint64_t)ink[c] << shift;
+        uint64_t m = (uint64_t)cover[c] << shift;
+        uint8_t* dst = buf + firstPage * SCREEN_WIDTH + x + c;
+        for (int p = firstPage; m && p < SCREEN_HEIGHT / 8; p++) {
+            uint8_t on = color ? (uint8_t)v : (uint8_t)(m & ~v);
+            *dst = (*dst & ~(uint8_t)m) | on;
+            v >>= 8;
+            m >>= 8;
+            dst += SCREEN_WIDTH;
+        }
+    }
+    return true;
+}
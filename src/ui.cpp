@@ -1,4 +1,6 @@
 #include "ui.h"
+#include "audio.h"
+#include "text_cache.h"
 #include <Wire.h>
 #include <Preferences.h>
 
@@ -12,7 +14,7 @@ void init() {
     Wire.begin(I2C_SDA, I2C_SCL);
     u8g2.begin();
     u8g2.setFont(u8g2_font_6x10_tf);
-    pinMode(BUZZER_PIN, OUTPUT);
+    Audio::init();
 }
 
 void clear() {
@@ -75,17 +77,38 @@ void drawTitleBar(const char* title) {
     u8g2.setDrawColor(1);
     u8g2.drawBox(0, 0, SCREEN_WIDTH, 11);
     u8g2.setDrawColor(0);
-    int w = u8g2.getStrWidth(title);
-    u8g2.drawStr((SCREEN_WIDTH - w) / 2, 9, title);
+    int w = TextCache::getStrWidth(title);
+    TextCache::drawStr((SCREEN_WIDTH - w) / 2, 9, title);
     u8g2.setDrawColor(1);
 }
 
+void drawStaleTag() {
+    // Small inverted tag in the title bar's right corner
+    setSmallFont();
+    u8g2.setDrawColor(0);
+    u8g2.drawStr(SCREEN_WIDTH - 17, 8, "old");
+    u8g2.setDrawColor(1);
+    setNormalFont();
+}
+
+void drawRetryHint(int y, unsigned long retryMs, const char* hint) {
+    setSmallFont();
+    if (retryMs > 0) {
+        char buf[24];
+        snprintf(buf, sizeof(buf), "Retrying in %lus", (retryMs + 999) / 1000);
+        drawCentered(y, buf);
+    } else {
+        drawCentered(y, hint);
+    }
+    setNormalFont();
+}
+
 void drawStatusBar(const char* left, const char* right) {
     u8g2.drawLine(0, 54, SCREEN_WIDTH - 1, 54);
-    if (left) u8g2.drawStr(2, 63, left);
+    if (left) TextCache::drawStr(2, 63, left);
     if (right) {
-        int w = u8g2.getStrWidth(right);
-        u8g2.drawStr(SCREEN_WIDTH - w - 2, 63, right);
+        int w = TextCache::getStrWidth(right);
+        TextCache::drawStr(SCREEN_WIDTH - w - 2, 63, right);
     }
 }
 
@@ -128,7 +151,7 @@ void drawScrollbar(int x, int y, int h, int pos, int total, int visible) {
 }
 
 void beep(int freq, int duration) {
-    tone(BUZZER_PIN, freq, duration);
+    Audio::tone(freq, duration, AUDIO_PRIO_UI);
 }
 
 void drawLoading(int x, int y, int frame) {
@@ -0,0 +1,226 @@
+#include "web_service.h"
+#include "wifi_manager.h"
+#include "web_assets.h"
+
+AsyncWebServer* WebService::server = nullptr;
+AsyncWebSocket* WebService::sockets[WEB_MAX_SOCKETS] = {nullptr};
+int WebService::socketCount = 0;
+bool WebService::running = false;
+
+AsyncWebServerRequest* WebService::admitted[WEB_MAX_CONNECTIONS] = {nullptr};
+AsyncWebServerRequest* WebService::lastRejected = nullptr;
+volatile int WebService::activeCount = 0;
+volatile int WebService::peakActive = 0;
+volatile uint32_t WebService::requestCount = 0;
+volatile uint32_t WebService::rejectedCount = 0;
+
+uint32_t WebService::rateBase = 0;
+unsigned long WebService::rateAt = 0;
+uint16_t WebService::rate = 0;
+uint16_t WebService::peakRate = 0;
+unsigned long WebService::lastCleanup = 0;
+
+volatile bool WebService::restartPending = false;
+volatile unsigned long WebService::restartAt = 0;
+
+void WebService::init() {
+    if (server) return;
+    server = new AsyncWebServer(WEB_PORT);
+
+    // Dashboard; live figures come from /api/status
+    onAsset("/", "index.html");
+    on("/api/status", HTTP_GET, handleStatus);
+    // Smallest possible response, for load testing (ab/wrk against /ping)
+    on("/ping", HTTP_GET, [](AsyncWebServerRequest* request) {
+        request->send(200, "text/plain", "pong");
+    });
+
+    server->onNotFound([](AsyncWebServerRequest* request) {
+        request->send(404, "text/plain", "Not found");
+    });
+}
+
+void WebService::update() {
+    if (!server) return;
+
+    // The listening socket survives reconnects, so start once
+    if (!running && WiFiManager::isConnected()) {
+        server->begin();
+        running = true;
+        rateAt = millis();
+        rateBase = requestCount;
+        Serial.printf("Web: listening on port %d\n", WEB_PORT);
+    }
+
+    unsigned long now = millis();
+    if (running && now - rateAt >= 1000) {
+        uint32_t count = requestCount;
+        rate = (uint16_t)((count - rateBase) * 1000UL / (now - rateAt));
+        if (rate > peakRate) peakRate = rate;
+        rateBase = count;
+        rateAt = now;
+    }
+
+    if (now - lastCleanup >= WEB_CLEANUP_MS) {
+        lastCleanup = now;
+        for (int i = 0; i < socketCount; i++) {
+            sockets[i]->cleanupClients(WEB_MAX_WS_CLIENTS);
+        }
+    }
+
+    if (restartPending && (long)(now - restartAt) >= 0) {
+        Serial.println("Web: restarting");
+        ESP.restart();
+    }
+}
+
+bool WebService::isRunning() {
+    return running;
+}
+
+// Runs on the AsyncTCP task. Sends the 503 itself; a rejected upload
+// comes back here once per chunk and once more for the final handler,
+// so only the first call answers.
+bool WebService::admit(AsyncWebServerRequest* request) {
+    if (request == lastRejected) return false;
+
+    int freeSlot = -1;
+    for (int i = 0; i < WEB_MAX_CONNECTIONS; i++) {
+        if (admitted[i] == request) return true;
+        if (!admitted[i] && freeSlot < 0) freeSlot = i;
+    }
+
+    if (freeSlot < 0) {
+        rejectedCount++;
+        lastRejected = request;
+        request->onDisconnect([request]() {
+            if (lastRejected == request) lastRejected = nullptr;
+        });
+        request->send(503, "text/plain", "Busy, try again");
+        return false;
+    }
+
+    admitted[freeSlot] = request;
+    activeCount++;
+    if (activeCount > peakActive) peakActive = activeCount;
+    requestCount++;
+    request->onDisconnect([request]() {
+        for (int i = 0; i < WEB_MAX_CONNECTIONS; i++) {
+            if (admitted[i] == request) {
+                admitted[i] = nullptr;
+                activeCount--;
+                break;
+            }
+        }
+    });
+    return true;
+}
+
+void WebService::on(const char* uri, WebRequestMethodComposite method,
+                    ArRequestHandlerFunction handler) {
+    if (!server) return;
+    server->on(uri, method, [handler](AsyncWebServerRequest* request) {
+        if (admit(request)) handler(request);
+    });
+}
+
+void WebService::on(const char* uri, WebRequestMethodComposite method,
+                    ArRequestHandlerFunction handler, ArUploadHandlerFunction upload) {
+    if (!server) return;
+    server->on(uri, method,
+        [handler](AsyncWebServerRequest* request) {
+            if (admit(request)) handler(request);
+        },
+        [upload](AsyncWebServerRequest* request, const String& filename,
+                 size_t index, uint8_t* data, size_t len, bool final) {
+            if (admit(request)) upload(request, filename, index, data, len, final);
+        });
+}
+
+void WebService::addWebSocket(AsyncWebSocket* ws) {
+    if (!server || socketCount >= WEB_MAX_SOCKETS) return;
+    sockets[socketCount++] = ws;
+    server->addHandler(ws);
+}
+
+void WebService::scheduleRestart(unsigned long delayMs) {
+    restartAt = millis() + delayMs;
+    restartPending = true;
+}
+
+void WebService::onAsset(const char* uri, const char* name) {
+    for (int i = 0; i < WEB_ASSET_COUNT; i++) {
+        if (strcmp(WEB_ASSETS[i].name, name) == 0) {
+            const WebAsset* asset = &WEB_ASSETS[i];
+            on(uri, HTTP_GET, [asset](AsyncWebServerRequest* request) {
+                sendAsset(request, asset);
+            });
+            return;
+        }
+    }
+    Serial.printf("Web: no asset %s (rebuild to regenerate web_assets.h)\n", name);
+}
+
+void WebService::sendAsset(AsyncWebServerRequest* request, const WebAsset* asset) {
+    if (request->hasHeader("If-None-Match") &&
+        request->getHeader("If-None-Match")->value() == asset->etag) {
+        AsyncWebServerResponse* response = request->beginResponse(304, asset->type, "");
+        response->addHeader("ETag", asset->etag);
+        request->send(response);
+        return;
+    }
+
+    // PROGMEM response: sent in TCP-window-sized chunks straight from flash.
+    // Every browser accepts gzip, so there is no uncompressed fallback.
+    AsyncWebServerResponse* response =
+        request->beginResponse(200, asset->type, asset->data, asset->len);
+    response->addHeader("Content-Encoding", "gzip");
+    response->addHeader("ETag", asset->etag);
+    response->addHeader("Cache-Control", "public, max-age=" + String(WEB_ASSET_MAX_AGE));
+    request->send(response);
+}
+
+void WebService::handleStatus(AsyncWebServerRequest* request) {
+    IPAddress ip = WiFiManager::getIP();
+
+    // SSIDs are free-form; keep the JSON well-formed
+    char ssid[33];
+    strncpy(ssid, WiFiManager::getSSID(), sizeof(ssid) - 1);
+    ssid[sizeof(ssid) - 1] = '\0';
+    for (char* c = ssid; *c; c++) {
+        if (*c == '"' || *c == '\\' || (uint8_t)*c < ' ') *c = '?';
+    }
+
+    char json[256];
+    snprintf(json, sizeof(json),
+        "{\"up\":%lu,\"heap\":%u,\"ssid\":\"%s\",\"rssi\":%d,\"ip\":\"%d.%d.%d.%d\","
+        "\"req\":%u,\"rate\":%u,\"peak\":%u,\"active\":%d,\"rej\":%u}",
+        millis() / 1000, ESP.getFreeHeap(), ssid, (int)WiFiManager::getRSSI(),
+        ip[0], ip[1], ip[2], ip[3],
+        requestCount, rate, peakRate, activeCount, rejectedCount);
+    request->send(200, "application/json", json);
+}
+
+uint32_t WebService::getRequestCount() {
+    return requestCount;
+}
+
+uint32_t WebService::getRejectedCount() {
+    return rejectedCount;
+}
+
+int WebService::getActiveCount() {
+    return activeCount;
+}
+
+int WebService::getPeakActive() {
+    return peakActive;
+}
+
+uint16_t WebService::getRequestRate() {
+    return rate;
+}
+
+uint16_t WebService::getPeakRate() {
+    return peakRate;
+}
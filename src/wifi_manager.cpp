@@ -1,75 +1,378 @@
 #include "wifi_manager.h"
 #include <HTTPClient.h>
+#include <WiFiClientSecure.h>
+#include <limits.h>
 #include "config.h"
+#include "http_fixtures.h"
+#include "http_inflate.h"
 
 Preferences WiFiManager::prefs;
 WiFiNetwork WiFiManager::scanResults[MAX_SCAN_RESULTS];
 int WiFiManager::scanCount = 0;
-char WiFiManager::savedSSIDs[MAX_SAVED_NETWORKS][33] = {0};
-char WiFiManager::savedPasswords[MAX_SAVED_NETWORKS][65] = {0};
+bool WiFiManager::scanning = false;
+bool WiFiManager::scanAnyOk = false;
+int WiFiManager::scanChannel = 0;
+unsigned long WiFiManager::scanStepStart = 0;
+unsigned long WiFiManager::scanDoneAt = 0;
+uint32_t WiFiManager::scanVersion = 0;
+SavedNetwork WiFiManager::saved[MAX_SAVED_NETWORKS] = {};
 int WiFiManager::savedCount = 0;
+uint32_t WiFiManager::connectSeq = 0;
+bool WiFiManager::netsDirty = false;
+unsigned long WiFiManager::netsSavedAt = 0;
 char WiFiManager::currentSSID[33] = {0};
 
 WiFiConnectState WiFiManager::connectState = WiFiConnectState::IDLE;
 int WiFiManager::connectingIndex = 0;
 unsigned long WiFiManager::attemptStart = 0;
+bool WiFiManager::attemptFast = false;
+volatile unsigned long WiFiManager::assocAt = 0;
+volatile unsigned long WiFiManager::gotIpAt = 0;
+volatile unsigned long WiFiManager::disconnectAt = 0;
+volatile uint8_t WiFiManager::disconnectReason = 0;
+
+char WiFiManager::manualSSID[33] = {0};
+char WiFiManager::manualPass[65] = {0};
+ConnectPhase WiFiManager::manualPhase = ConnectPhase::NONE;
+unsigned long WiFiManager::phaseStart = 0;
+char WiFiManager::connectError[32] = {0};
+bool WiFiManager::internetOk = false;
+volatile int8_t WiFiManager::internetResult = -1;
+volatile uint32_t WiFiManager::checkGeneration = 0;
+ConnectCandidate WiFiManager::candidates[MAX_SAVED_NETWORKS];
+int WiFiManager::candidateCount = 0;
+int WiFiManager::candidatePos = 0;
+
+HostHealth WiFiManager::hosts[MAX_TRACKED_HOSTS];
+int WiFiManager::hostCount = 0;
+uint32_t WiFiManager::totalFailures = 0;
+uint32_t WiFiManager::connectCount = 0;
+uint32_t WiFiManager::dropCount = 0;
+
+RequestRecord WiFiManager::requestLog[NET_LOG_SIZE];
+int WiFiManager::requestLogHead = 0;
+int WiFiManager::requestLogCount = 0;
+uint32_t WiFiManager::totalRequestBytes = 0;
+uint32_t WiFiManager::totalWireBytes = 0;
+
+DnsEntry WiFiManager::dnsCache[DNS_CACHE_SIZE];
+int WiFiManager::dnsCount = 0;
+DnsStats WiFiManager::dnsStats = {};
+char WiFiManager::dnsNetwork[33] = {0};
+int WiFiManager::prefetchIndex = -1;
+bool WiFiManager::prefetchPending = false;
+unsigned long WiFiManager::prefetchStart = 0;
+volatile bool WiFiManager::prefetchDone = false;
+volatile uint32_t WiFiManager::prefetchIp = 0;
+volatile uint32_t WiFiManager::prefetchGen = 0;
+
+// Hosts the apps talk to, resolved in the background after each connect
+static const char* const PREFETCH_HOSTS[] = {
+    "api.coingecko.com",
+    "api.openweathermap.org",
+    "newsapi.org",
+    "api.open-notify.org",
+    "v2.jokeapi.dev",
+    "uselessfacts.jsph.pl",
+    "api.quotable.io",
+    "opentdb.com",
+};
+static const int PREFETCH_HOST_COUNT = sizeof(PREFETCH_HOSTS) / sizeof(PREFETCH_HOSTS[0]);
 
 static const unsigned long PER_ATTEMPT_MS = 10000;
+// Give up on a channel whose scan never reports completion
+static const unsigned long SCAN_STEP_TIMEOUT_MS = 1500;
+// WiFi.status() may still report the previous attempt's failure for a
+// moment after begin(); only trust failure states after this long
+static const unsigned long FAIL_SETTLE_MS = 1000;
+// Connect history counts toward a candidate's rank up to these
+static const int RANK_MAX_SUCCESSES = 10;
+static const int RANK_MAX_FAILURES = 5;
+
+// Saved networks are stored as a single NVS blob:
+//   [version][count] then per network
+//   [ssidLen][ssid][passLen][pass][FastConnectInfo][lastUsed u32][successes u16][failures u16]
+static const uint8_t NETS_BLOB_VERSION = 1;
+static const size_t NETS_ENTRY_MAX = 1 + 32 + 1 + 64 + sizeof(FastConnectInfo) + 4 + 2 + 2;
+static const int LEGACY_MAX_NETWORKS = 3;
+
+static size_t writeString(uint8_t* p, const char* s) {
+    size_t n = strlen(s);
+    p[0] = (uint8_t)n;
+    memcpy(p + 1, s, n);
+    return n + 1;
+}
+
+static bool readString(const uint8_t* buf, size_t len, size_t& pos, char* out, size_t outSize) {
+    if (pos >= len) return false;
+    size_t n = buf[pos++];
+    if (n >= outSize || pos + n > len) return false;
+    memcpy(out, buf + pos, n);
+    out[n] = '\0';
+    pos += n;
+    return true;
+}
 
 void WiFiManager::init() {
+    // Credentials live in our own NVS namespace; reconnects are driven by
+    // update() so they can use the fast path instead of the SDK's retry
+    WiFi.persistent(false);
+    WiFi.setAutoReconnect(false);
     WiFi.mode(WIFI_STA);
     WiFi.disconnect();
+    WiFi.onEvent(onWiFiEvent);
     loadSavedNetworks();
 }
 
+void WiFiManager::onWiFiEvent(WiFiEvent_t event, WiFiEventInfo_t info) {
+    // Runs on the WiFi event task: only timestamp the connect phases
+    if (event == ARDUINO_EVENT_WIFI_STA_CONNECTED) {
+        assocAt = millis();
+    } else if (event == ARDUINO_EVENT_WIFI_STA_GOT_IP) {
+        gotIpAt = millis();
+    } else if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED) {
+        disconnectReason = info.wifi_sta_disconnected.reason;
+        disconnectAt = millis();
+    }
+}
+
 void WiFiManager::loadSavedNetworks() {
+    static uint8_t buf[2 + MAX_SAVED_NETWORKS * NETS_ENTRY_MAX];
+
+    savedCount = 0;
+    connectSeq = 0;
+
     prefs.begin(NVS_NAMESPACE, true);  // Read-only
+    size_t len = prefs.getBytesLength("wifi_nets");
+    if (len >= 2 && len <= sizeof(buf)) {
+        len = prefs.getBytes("wifi_nets", buf, len);
+    } else {
+        len = 0;
+    }
+    prefs.end();
 
-    savedCount = prefs.getInt("wifi_count", 0);
-    if (savedCount > MAX_SAVED_NETWORKS) savedCount = MAX_SAVED_NETWORKS;
+    if (len == 0) {
+        // First boot with the blob layout: migrate the old per-index keys
+        if (loadLegacyNetworks()) {
+            saveSavedNetworks();
+            prefs.begin(NVS_NAMESPACE, false);
+            for (int i = 0; i < LEGACY_MAX_NETWORKS; i++) {
+                char key[16];
+                snprintf(key, sizeof(key), "wifi_ssid_%d", i);
+                prefs.remove(key);
+                snprintf(key, sizeof(key), "wifi_pass_%d", i);
+                prefs.remove(key);
+                snprintf(key, sizeof(key), "wifi_fc_%d", i);
+                prefs.remove(key);
+            }
+            prefs.remove("wifi_count");
+            prefs.end();
+        }
+        return;
+    }
+    if (buf[0] != NETS_BLOB_VERSION) return;
 
-    for (int i = 0; i < savedCount; i++) {
-        char keySSID[16], keyPass[16];
+    int count = buf[1];
+    size_t pos = 2;
+    while (savedCount < count && savedCount < MAX_SAVED_NETWORKS) {
+        SavedNetwork& n = saved[savedCount];
+        memset(&n, 0, sizeof(n));
+        if (!readString(buf, len, pos, n.ssid, sizeof(n.ssid))) break;
+        if (!readString(buf, len, pos, n.password, sizeof(n.password))) break;
+        if (pos + sizeof(FastConnectInfo) + 8 > len) break;
+
+        memcpy(&n.fast, buf + pos, sizeof(FastConnectInfo));
+        pos += sizeof(FastConnectInfo);
+        memcpy(&n.lastUsed, buf + pos, 4);
+        memcpy(&n.successes, buf + pos + 4, 2);
+        memcpy(&n.failures, buf + pos + 6, 2);
+        pos += 8;
+
+        if (n.lastUsed > connectSeq) connectSeq = n.lastUsed;
+        savedCount++;
+    }
+}
+
+bool WiFiManager::loadLegacyNetworks() {
+    prefs.begin(NVS_NAMESPACE, true);
+
+    int count = prefs.getInt("wifi_count", 0);
+    if (count > LEGACY_MAX_NETWORKS) count = LEGACY_MAX_NETWORKS;
+
+    for (int i = 0; i < count; i++) {
+        SavedNetwork& n = saved[i];
+        memset(&n, 0, sizeof(n));
+
+        char keySSID[16], keyPass[16], keyFast[16];
         snprintf(keySSID, sizeof(keySSID), "wifi_ssid_%d", i);
         snprintf(keyPass, sizeof(keyPass), "wifi_pass_%d", i);
+        snprintf(keyFast, sizeof(keyFast), "wifi_fc_%d", i);
 
-        prefs.getString(keySSID, savedSSIDs[i], sizeof(savedSSIDs[i]));
-        prefs.getString(keyPass, savedPasswords[i], sizeof(savedPasswords[i]));
+        prefs.getString(keySSID, n.ssid, sizeof(n.ssid));
+        prefs.getString(keyPass, n.password, sizeof(n.password));
+        if (prefs.getBytes(keyFast, &n.fast, sizeof(FastConnectInfo)) != sizeof(FastConnectInfo)) {
+            memset(&n.fast, 0, sizeof(FastConnectInfo));
+        }
     }
 
     prefs.end();
+    savedCount = count;
+    return count > 0;
 }
 
 void WiFiManager::saveSavedNetworks() {
+    static uint8_t buf[2 + MAX_SAVED_NETWORKS * NETS_ENTRY_MAX];
+
+    size_t pos = 0;
+    buf[pos++] = NETS_BLOB_VERSION;
+    buf[pos++] = (uint8_t)savedCount;
+    for (int i = 0; i < savedCount; i++) {
+        const SavedNetwork& n = saved[i];
+        pos += writeString(buf + pos, n.ssid);
+        pos += writeString(buf + pos, n.password);
+        memcpy(buf + pos, &n.fast, sizeof(FastConnectInfo));
+        pos += sizeof(FastConnectInfo);
+        memcpy(buf + pos, &n.lastUsed, 4);
+        memcpy(buf + pos + 4, &n.successes, 2);
+        memcpy(buf + pos + 6, &n.failures, 2);
+        pos += 8;
+    }
+
     prefs.begin(NVS_NAMESPACE, false);  // Read-write
+    prefs.putBytes("wifi_nets", buf, pos);
+    prefs.end();
+    netsDirty = false;
+    netsSavedAt = millis();
+}
 
-    prefs.putInt("wifi_count", savedCount);
+// Pending connect history; anything the user changed is saved right away
+void WiFiManager::saveSavedNetworksThrottled() {
+    if (!netsDirty) return;
+    if (netsSavedAt && millis() - netsSavedAt < WIFI_NETS_SAVE_MS) return;
+    saveSavedNetworks();
+}
 
-    for (int i = 0; i < savedCount; i++) {
-        char keySSID[16], keyPass[16];
-        snprintf(keySSID, sizeof(keySSID), "wifi_ssid_%d", i);
-        snprintf(keyPass, sizeof(keyPass), "wifi_pass_%d", i);
+bool WiFiManager::startScan(bool force) {
+    if (scanning) return true;
+    if (!force && scanDoneAt && millis() - scanDoneAt < WIFI_SCAN_CACHE_MS) return false;
 
-        prefs.putString(keySSID, savedSSIDs[i]);
-        prefs.putString(keyPass, savedPasswords[i]);
+    // Keep the old list on screen; entries not seen again are dropped
+    // when the scan finishes
+    for (int i = 0; i < scanCount; i++) scanResults[i].seen = false;
+    scanning = true;
+    scanAnyOk = false;
+    scanChannel = 0;  // Started from updateScan()
+    return true;
+}
+
+bool WiFiManager::isScanning() {
+    return scanning;
+}
+
+int WiFiManager::getScanChannel() {
+    return scanChannel;
+}
+
+unsigned long WiFiManager::getScanAge() {
+    if (!scanDoneAt) return ULONG_MAX;
+    return millis() - scanDoneAt;
+}
+
+uint32_t WiFiManager::getScanVersion() {
+    return scanVersion;
+}
+
+void WiFiManager::beginScanStep() {
+    WiFi.scanNetworks(true, false, false, WIFI_SCAN_DWELL_MS, scanChannel);
+    scanStepStart = millis();
+}
+
+void WiFiManager::updateScan() {
+    if (!scanning) return;
+
+    if (scanChannel == 0) {
+        // The radio can't scan while a join is in progress
+        if (connectState == WiFiConnectState::CONNECTING) return;
+        scanChannel = 1;
+        beginScanStep();
+        return;
     }
 
-    prefs.end();
+    int16_t found = WiFi.scanComplete();
+    if (found == WIFI_SCAN_RUNNING && millis() - scanStepStart < SCAN_STEP_TIMEOUT_MS) return;
+    if (found >= 0) {
+        mergeScanResults(found);
+        scanAnyOk = true;
+    }
+    WiFi.scanDelete();
+
+    if (++scanChannel > WIFI_SCAN_CHANNELS) {
+        finishScan();
+    } else {
+        beginScanStep();
+    }
 }
 
-int WiFiManager::scan() {
-    scanCount = WiFi.scanNetworks();
-    if (scanCount > MAX_SCAN_RESULTS) scanCount = MAX_SCAN_RESULTS;
+void WiFiManager::mergeScanResults(int found) {
+    for (int i = 0; i < found; i++) {
+        String ssid = WiFi.SSID(i);
+        if (ssid.length() == 0) continue;
+        int32_t rssi = WiFi.RSSI(i);
 
+        WiFiNetwork* n = nullptr;
+        for (int j = 0; j < scanCount; j++) {
+            if (strcmp(scanResults[j].ssid, ssid.c_str()) == 0) { n = &scanResults[j]; break; }
+        }
+        if (n) {
+            // Another BSSID of a known SSID: keep the strongest
+            if (n->seen && n->rssi >= rssi) continue;
+        } else if (scanCount < MAX_SCAN_RESULTS) {
+            n = &scanResults[scanCount++];
+        } else {
+            // List is full: evict the weakest. Not necessarily the last
+            // slot, the list is only sorted once the merge is done.
+            WiFiNetwork* weakest = &scanResults[0];
+            for (int j = 1; j < scanCount; j++) {
+                if (scanResults[j].rssi < weakest->rssi) weakest = &scanResults[j];
+            }
+            if (rssi <= weakest->rssi) continue;
+            n = weakest;
+        }
+
+        strncpy(n->ssid, ssid.c_str(), sizeof(n->ssid) - 1);
+        n->ssid[sizeof(n->ssid) - 1] = '\0';
+        n->rssi = rssi;
+        n->open = (WiFi.encryptionType(i) == WIFI_AUTH_OPEN);
+        n->channel = (uint8_t)WiFi.channel(i);
+        memcpy(n->bssid, WiFi.BSSID(i), sizeof(n->bssid));
+        n->seen = true;
+    }
+
+    // Insertion sort by RSSI, strongest first
+    for (int i = 1; i < scanCount; i++) {
+        WiFiNetwork n = scanResults[i];
+        int j = i - 1;
+        while (j >= 0 && scanResults[j].rssi < n.rssi) {
+            scanResults[j + 1] = scanResults[j];
+            j--;
+        }
+        scanResults[j + 1] = n;
+    }
+    scanVersion++;
+}
+
+void WiFiManager::finishScan() {
+    // Drop networks left over from the previous scan that are gone now
+    int kept = 0;
     for (int i = 0; i < scanCount; i++) {
-        strncpy(scanResults[i].ssid, WiFi.SSID(i).c_str(), 32);
-        scanResults[i].ssid[32] = '\0';
-        scanResults[i].rssi = WiFi.RSSI(i);
-        scanResults[i].open = (WiFi.encryptionType(i) == WIFI_AUTH_OPEN);
+        if (scanResults[i].seen) scanResults[kept++] = scanResults[i];
     }
+    scanCount = kept;
 
-    WiFi.scanDelete();
-    return scanCount;
+    scanning = false;
+    scanChannel = 0;
+    scanDoneAt = millis();
+    scanVersion++;
 }
 
 WiFiNetwork* WiFiManager::getScanResults() {
@@ -80,30 +383,190 @@ int WiFiManager::getScanCount() {
     return scanCount;
 }
 
-bool WiFiManager::connect(const char* ssid, const char* password) {
+void WiFiManager::connectAsync(const char* ssid, const char* password) {
+    strncpy(manualSSID, ssid, sizeof(manualSSID) - 1);
+    manualSSID[sizeof(manualSSID) - 1] = '\0';
+    strncpy(manualPass, password ? password : "", sizeof(manualPass) - 1);
+    manualPass[sizeof(manualPass) - 1] = '\0';
+
+    connectError[0] = '\0';
+    internetOk = false;
+    currentSSID[0] = '\0';
+    checkGeneration++;  // Drop the result of any earlier check
+
+    // CONNECTING also holds off new scans and pauses auto-connect
+    connectState = WiFiConnectState::CONNECTING;
+    manualPhase = ConnectPhase::WAITING;
+    phaseStart = millis();
+}
+
+void WiFiManager::cancelConnect() {
+    if (manualPhase == ConnectPhase::NONE || manualPhase == ConnectPhase::DONE ||
+        manualPhase == ConnectPhase::FAILED) {
+        return;
+    }
+    Serial.printf("WiFi: connect to %s cancelled\n", manualSSID);
+    checkGeneration++;
+    memset(manualPass, 0, sizeof(manualPass));
+    manualPhase = ConnectPhase::NONE;
     WiFi.disconnect();
-    delay(100);
+    connectState = WiFiConnectState::IDLE;
+    autoConnect();  // Back to the saved networks
+}
 
-    if (password && strlen(password) > 0) {
-        WiFi.begin(ssid, password);
-    } else {
-        WiFi.begin(ssid);
+ConnectPhase WiFiManager::getConnectPhase() {
+    return manualPhase;
+}
+
+const char* WiFiManager::getConnectError() {
+    return connectError;
+}
+
+bool WiFiManager::hasInternet() {
+    return internetOk;
+}
+
+void WiFiManager::beginManual() {
+    WiFi.disconnect();
+
+    // Manual connects always scan; keep a static profile if one is set
+    int known = findSaved(manualSSID);
+    applyIPConfig(known >= 0 ? &saved[known].fast : nullptr, false);
+    WiFi.begin(manualSSID, manualPass[0] ? manualPass : nullptr);
+
+    attemptFast = false;
+    attemptStart = phaseStart = millis();
+    assocAt = gotIpAt = disconnectAt = 0;
+    manualPhase = ConnectPhase::JOINING;
+}
+
+bool WiFiManager::joinFailed() {
+    // Our own disconnect() before begin() reports ASSOC_LEAVE; ignore it
+    return disconnectAt != 0 && disconnectReason != WIFI_REASON_ASSOC_LEAVE;
+}
+
+const char* WiFiManager::describeReason(uint8_t reason) {
+    switch (reason) {
+        case WIFI_REASON_AUTH_FAIL:
+        case WIFI_REASON_AUTH_EXPIRE:
+        case WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT:
+        case WIFI_REASON_HANDSHAKE_TIMEOUT:
+        case WIFI_REASON_MIC_FAILURE:
+            return "Wrong password";
+        case WIFI_REASON_NO_AP_FOUND:
+            return "Network not found";
+        case WIFI_REASON_ASSOC_FAIL:
+        case WIFI_REASON_ASSOC_EXPIRE:
+        case WIFI_REASON_ASSOC_TOOMANY:
+            return "AP refused join";
+        case WIFI_REASON_BEACON_TIMEOUT:
+            return "Signal lost";
+        default:
+            return "Connection failed";
     }
+}
 
-    // Wait for connection (timeout 10 seconds)
-    int timeout = 100;  // 100 * 100ms = 10s
-    while (WiFi.status() != WL_CONNECTED && timeout > 0) {
-        delay(100);
-        timeout--;
+void WiFiManager::updateManual() {
+    unsigned long elapsed = millis() - phaseStart;
+
+    switch (manualPhase) {
+        case ConnectPhase::WAITING:
+            // A scan that has started must finish first; one that is
+            // still waiting to start waits for us instead
+            if (scanning && scanChannel != 0) return;
+            beginManual();
+            break;
+
+        case ConnectPhase::JOINING:
+            if (WiFi.status() == WL_CONNECTED) {
+                startInternetCheck();   // Associated and got an IP in one go
+            } else if (assocAt) {
+                manualPhase = ConnectPhase::DHCP;
+                phaseStart = millis();
+            } else if (joinFailed()) {
+                failManual(describeReason(disconnectReason));
+            } else if (elapsed >= PER_ATTEMPT_MS) {
+                failManual("Timed out joining");
+            }
+            break;
+
+        case ConnectPhase::DHCP:
+            if (WiFi.status() == WL_CONNECTED) {
+                startInternetCheck();
+            } else if (joinFailed()) {
+                failManual(describeReason(disconnectReason));
+            } else if (elapsed >= WIFI_DHCP_TIMEOUT_MS) {
+                failManual("No IP address");
+            }
+            break;
+
+        case ConnectPhase::INTERNET_CHECK:
+            // The probe task gives up on its own; this is just a backstop
+            if (internetResult < 0 && elapsed < WIFI_INTERNET_CHECK_MS * 2) return;
+            internetOk = (internetResult == 1);
+            finishManual();
+            break;
+
+        default:
+            break;
     }
+}
 
-    if (WiFi.status() == WL_CONNECTED) {
-        strncpy(currentSSID, ssid, sizeof(currentSSID) - 1);
-        connectState = WiFiConnectState::CONNECTED;
-        return true;
+void WiFiManager::startInternetCheck() {
+    manualPhase = ConnectPhase::INTERNET_CHECK;
+    phaseStart = millis();
+    internetResult = -1;
+
+    // HTTPClient blocks, so probe from a short-lived task
+    uint32_t generation = ++checkGeneration;
+    if (xTaskCreate(internetCheckTask, "netcheck", 4096, (void*)(uintptr_t)generation, 1, nullptr) != pdPASS) {
+        internetResult = 0;
     }
+}
 
-    return false;
+void WiFiManager::internetCheckTask(void* arg) {
+    uint32_t generation = (uint32_t)(uintptr_t)arg;
+
+    HTTPClient http;
+    http.setConnectTimeout(WIFI_INTERNET_CHECK_MS);
+    http.setTimeout(WIFI_INTERNET_CHECK_MS);
+    int code = -1;
+    if (http.begin(WIFI_INTERNET_CHECK_URL)) {
+        code = http.GET();
+        http.end();
+    }
+
+    // Captive portals answer with a redirect or a login page, not 204
+    if (generation == checkGeneration) {
+        internetResult = (code == HTTP_CODE_NO_CONTENT) ? 1 : 0;
+    }
+    vTaskDelete(nullptr);
+}
+
+void WiFiManager::finishManual() {
+    strncpy(currentSSID, manualSSID, sizeof(currentSSID) - 1);
+    currentSSID[sizeof(currentSSID) - 1] = '\0';
+    connectState = WiFiConnectState::CONNECTED;
+    manualPhase = ConnectPhase::DONE;
+
+    logConnectTiming(currentSSID);
+    Serial.printf("WiFi: internet %s\n", internetOk ? "reachable" : "NOT reachable");
+
+    saveNetwork(manualSSID, manualPass);  // Also records the join for fast reconnect
+    memset(manualPass, 0, sizeof(manualPass));
+    onConnected();
+}
+
+void WiFiManager::failManual(const char* reason) {
+    Serial.printf("WiFi: connect to %s failed: %s\n", manualSSID, reason);
+    strncpy(connectError, reason, sizeof(connectError) - 1);
+    connectError[sizeof(connectError) - 1] = '\0';
+    memset(manualPass, 0, sizeof(manualPass));
+    manualPhase = ConnectPhase::FAILED;
+
+    WiFi.disconnect();
+    connectState = WiFiConnectState::IDLE;
+    autoConnect();  // Back to the saved networks
 }
 
 void WiFiManager::disconnect() {
@@ -116,13 +579,202 @@ bool WiFiManager::isConnected() {
     return WiFi.status() == WL_CONNECTED;
 }
 
-void WiFiManager::beginAttempt(int index) {
+bool WiFiManager::canFetch() {
+    if (HttpFixtures::isReplaying() && !HTTP_FIXTURE_BASE_URL[0]) return true;
+    return isConnected();
+}
+
+int WiFiManager::findSaved(const char* ssid) {
+    for (int i = 0; i < savedCount; i++) {
+        if (strcmp(saved[i].ssid, ssid) == 0) return i;
+    }
+    return -1;
+}
+
+int WiFiManager::mostRecentSaved() {
+    int best = -1;
+    for (int i = 0; i < savedCount; i++) {
+        if (saved[i].lastUsed == 0) continue;
+        if (best < 0 || saved[i].lastUsed > saved[best].lastUsed) best = i;
+    }
+    return best;
+}
+
+void WiFiManager::applyIPConfig(const FastConnectInfo* fc, bool useLease) {
+    if (fc && (fc->flags & FC_STATIC)) {
+        WiFi.config(IPAddress(fc->ip), IPAddress(fc->gateway), IPAddress(fc->subnet), IPAddress(fc->dns));
+    } else if (fc && useLease && (fc->flags & FC_HAS_LEASE)) {
+        WiFi.config(IPAddress(fc->ip), IPAddress(fc->gateway), IPAddress(fc->subnet), IPAddress(fc->dns));
+    } else {
+        // All-zero config switches the DHCP client back on
+        WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+    }
+}
+
+void WiFiManager::beginAttempt(int index, bool fast) {
     WiFi.disconnect();
-    if (strlen(savedPasswords[index]) > 0) {
-        WiFi.begin(savedSSIDs[index], savedPasswords[index]);
+
+    const SavedNetwork& n = saved[index];
+    attemptFast = fast && (n.fast.flags & FC_VALID);
+    applyIPConfig(&n.fast, attemptFast && WIFI_REUSE_LEASE);
+
+    const char* pass = strlen(n.password) > 0 ? n.password : nullptr;
+    if (attemptFast) {
+        // Known channel + BSSID: join directly, no scan
+        WiFi.begin(n.ssid, pass, n.fast.channel, n.fast.bssid);
     } else {
-        WiFi.begin(savedSSIDs[index]);
+        WiFi.begin(n.ssid, pass);
     }
+
+    connectingIndex = index;
+    attemptStart = millis();
+    assocAt = gotIpAt = 0;
+}
+
+void WiFiManager::beginCandidate(int pos) {
+    WiFi.disconnect();
+
+    const ConnectCandidate& c = candidates[pos];
+    const SavedNetwork& n = saved[c.index];
+
+    // Same AP as last time: the cached lease is still a good bet
+    bool sameAP = (n.fast.flags & FC_VALID) && c.channel &&
+                  memcmp(n.fast.bssid, c.bssid, sizeof(c.bssid)) == 0;
+    applyIPConfig(&n.fast, sameAP && WIFI_REUSE_LEASE);
+
+    const char* pass = strlen(n.password) > 0 ? n.password : nullptr;
+    if (c.channel) {
+        // Join the BSSID the scan just saw, so begin() doesn't scan again
+        WiFi.begin(n.ssid, pass, c.channel, c.bssid);
+    } else {
+        WiFi.begin(n.ssid, pass);
+    }
+
+    candidatePos = pos;
+    connectingIndex = c.index;
+    attemptFast = false;
+    attemptStart = millis();
+    assocAt = gotIpAt = 0;
+}
+
+void WiFiManager::startCandidateScan() {
+    WiFi.disconnect();
+    WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+    connectState = WiFiConnectState::SCANNING;
+    startScan(true);  // Shared with Settings; progresses in update()
+    candidateCount = 0;
+    candidatePos = 0;
+    attemptFast = false;
+    attemptStart = millis();
+}
+
+void WiFiManager::rankCandidates() {
+    candidateCount = 0;
+
+    if (scanAnyOk) {
+        // Saved networks in range; the scan list already holds only the
+        // strongest BSSID of each SSID
+        for (int i = 0; i < scanCount; i++) {
+            int idx = findSaved(scanResults[i].ssid);
+            if (idx < 0) continue;
+
+            ConnectCandidate& c = candidates[candidateCount++];
+            c.index = (int8_t)idx;
+            c.rssi = scanResults[i].rssi;
+            c.channel = scanResults[i].channel;
+            memcpy(c.bssid, scanResults[i].bssid, sizeof(c.bssid));
+        }
+    } else {
+        // Scan failed: fall back to trying everything, ranked by history
+        for (int i = 0; i < savedCount; i++) {
+            ConnectCandidate& c = candidates[candidateCount++];
+            memset(&c, 0, sizeof(c));
+            c.index = (int8_t)i;
+            c.rssi = -90;
+        }
+    }
+
+    // Score: signal strength, nudged by how reliable the network has been
+    int recent = mostRecentSaved();
+    for (int i = 0; i < candidateCount; i++) {
+        const SavedNetwork& n = saved[candidates[i].index];
+        int32_t score = candidates[i].rssi;
+        score += 3 * min((int)n.successes, RANK_MAX_SUCCESSES);
+        score -= 8 * min((int)n.failures, RANK_MAX_FAILURES);
+        if (candidates[i].index == recent) score += 5;
+        candidates[i].score = score;
+    }
+
+    // Insertion sort, best first (at most MAX_SAVED_NETWORKS entries)
+    for (int i = 1; i < candidateCount; i++) {
+        ConnectCandidate c = candidates[i];
+        int j = i - 1;
+        while (j >= 0 && candidates[j].score < c.score) {
+            candidates[j + 1] = candidates[j];
+            j--;
+        }
+        candidates[j + 1] = c;
+    }
+
+    for (int i = 0; i < candidateCount; i++) {
+        Serial.printf("WiFi: candidate %d %s rssi %ld score %ld\n", i,
+                      saved[candidates[i].index].ssid,
+                      (long)candidates[i].rssi, (long)candidates[i].score);
+    }
+}
+
+// Counters are kept in RAM and marked for writing only when the ranking
+// would see the difference: capped counts past their cap, or another
+// success of the network that is already the most recent, change nothing
+void WiFiManager::recordAttempt(int index, bool success) {
+    if (index < 0 || index >= savedCount) return;
+
+    SavedNetwork& n = saved[index];
+    if (success) {
+        if (n.failures > 0 || n.successes < RANK_MAX_SUCCESSES || mostRecentSaved() != index) {
+            netsDirty = true;
+        }
+        n.lastUsed = ++connectSeq;
+        if (n.successes < 0xFFFF) n.successes++;
+        n.failures = 0;
+    } else {
+        if (n.failures < RANK_MAX_FAILURES) netsDirty = true;
+        if (n.failures < 0xFFFF) n.failures++;
+    }
+    saveSavedNetworksThrottled();
+}
+
+void WiFiManager::captureFastConnect(int index) {
+    if (index < 0 || index >= savedCount) return;
+
+    FastConnectInfo& fc = saved[index].fast;
+    FastConnectInfo before = fc;
+    const uint8_t* bssid = WiFi.BSSID();
+    if (bssid) memcpy(fc.bssid, bssid, sizeof(fc.bssid));
+    fc.channel = (uint8_t)WiFi.channel();
+    fc.flags |= FC_VALID;
+
+    if (!(fc.flags & FC_STATIC)) {
+        fc.ip = (uint32_t)WiFi.localIP();
+        fc.gateway = (uint32_t)WiFi.gatewayIP();
+        fc.subnet = (uint32_t)WiFi.subnetMask();
+        fc.dns = (uint32_t)WiFi.dnsIP(0);
+        fc.flags |= FC_HAS_LEASE;
+    }
+
+    // A new channel, BSSID or lease matters for the next fast join
+    if (memcmp(&before, &fc, sizeof(fc)) != 0) {
+        netsDirty = true;
+        netsSavedAt = 0;
+    }
+}
+
+void WiFiManager::logConnectTiming(const char* ssid) {
+    unsigned long now = millis();
+    unsigned long assoc = assocAt ? assocAt - attemptStart : now - attemptStart;
+    unsigned long ip = gotIpAt ? gotIpAt - attemptStart : now - attemptStart;
+    Serial.printf("WiFi: %s via %s, assoc %lums, ip %lums, total %lums\n",
+                  ssid, attemptFast ? "cache" : "scan", assoc, ip, now - attemptStart);
 }
 
 bool WiFiManager::autoConnect() {
@@ -130,38 +782,95 @@ bool WiFiManager::autoConnect() {
         connectState = WiFiConnectState::FAILED_ALL;
         return false;
     }
-    connectingIndex = 0;
-    beginAttempt(connectingIndex);
-    connectState = WiFiConnectState::CONNECTING;
-    attemptStart = millis();
+
+    // The network we were last on usually still is there: try it from
+    // the cache first, and only scan if that doesn't work out
+    int recent = mostRecentSaved();
+    if (recent >= 0 && (saved[recent].fast.flags & FC_VALID)) {
+        beginAttempt(recent, true);
+        connectState = WiFiConnectState::CONNECTING;
+    } else {
+        startCandidateScan();
+    }
     return true;
 }
 
 void WiFiManager::update() {
+    updateScan();
+    saveSavedNetworksThrottled();
+
+    if (manualPhase == ConnectPhase::WAITING || manualPhase == ConnectPhase::JOINING ||
+        manualPhase == ConnectPhase::DHCP || manualPhase == ConnectPhase::INTERNET_CHECK) {
+        updateManual();
+        return;
+    }
+
     if (connectState == WiFiConnectState::CONNECTED) {
         if (WiFi.status() != WL_CONNECTED) {
-            connectState = WiFiConnectState::IDLE;
+            // Dropped (AP gone, or we just woke from light sleep):
+            // reconnect through the cached fast path
+            Serial.printf("WiFi: lost %s, reconnecting\n", currentSSID);
+            dropCount++;
             currentSSID[0] = '\0';
+            connectState = WiFiConnectState::IDLE;
+            autoConnect();
+            return;
         }
+        updatePrefetch();
         return;
     }
+
+    if (connectState == WiFiConnectState::SCANNING) {
+        if (scanning) return;
+
+        rankCandidates();
+
+        if (candidateCount == 0) {
+            Serial.println("WiFi: no saved network in range");
+            connectState = WiFiConnectState::FAILED_ALL;
+            return;
+        }
+        connectState = WiFiConnectState::CONNECTING;
+        beginCandidate(0);
+        return;
+    }
+
     if (connectState != WiFiConnectState::CONNECTING) return;
 
-    if (WiFi.status() == WL_CONNECTED) {
-        strncpy(currentSSID, savedSSIDs[connectingIndex], sizeof(currentSSID) - 1);
+    wl_status_t status = WiFi.status();
+    if (status == WL_CONNECTED) {
+        strncpy(currentSSID, saved[connectingIndex].ssid, sizeof(currentSSID) - 1);
         currentSSID[sizeof(currentSSID) - 1] = '\0';
         connectState = WiFiConnectState::CONNECTED;
+        logConnectTiming(currentSSID);
+        captureFastConnect(connectingIndex);
+        recordAttempt(connectingIndex, true);
+        onConnected();
+        return;
+    }
+
+    unsigned long elapsed = millis() - attemptStart;
+    bool failed = elapsed >= FAIL_SETTLE_MS &&
+                  (status == WL_NO_SSID_AVAIL || status == WL_CONNECT_FAILED);
+
+    if (attemptFast) {
+        // Cached BSSID/channel didn't work (AP moved channel, replaced, or
+        // out of range): scan and rank everything that is in range
+        if (elapsed >= WIFI_FAST_ATTEMPT_MS || failed) {
+            Serial.printf("WiFi: fast join of %s failed after %lums, scanning\n",
+                          saved[connectingIndex].ssid, elapsed);
+            startCandidateScan();
+        }
         return;
     }
 
-    if (millis() - attemptStart >= PER_ATTEMPT_MS) {
-        connectingIndex++;
-        if (connectingIndex >= savedCount) {
+    if (elapsed >= PER_ATTEMPT_MS || failed) {
+        recordAttempt(connectingIndex, false);
+        if (candidatePos + 1 >= candidateCount) {
             connectState = WiFiConnectState::FAILED_ALL;
             return;
         }
-        beginAttempt(connectingIndex);
-        attemptStart = millis();
+        beginCandidate(candidatePos + 1);
     }
 }
 
@@ -189,42 +898,42 @@ int32_t WiFiManager::getRSSI() {
 }
 
 void WiFiManager::saveNetwork(const char* ssid, const char* password) {
-    // Check if already saved
-    for (int i = 0; i < savedCount; i++) {
-        if (strcmp(savedSSIDs[i], ssid) == 0) {
-            // Update password
-            strncpy(savedPasswords[i], password, sizeof(savedPasswords[i]) - 1);
-            saveSavedNetworks();
-            return;
+    int idx = findSaved(ssid);
+
+    if (idx < 0) {
+        if (savedCount < MAX_SAVED_NETWORKS) {
+            idx = savedCount++;
+        } else {
+            // Full: replace the least recently used network
+            idx = 0;
+            for (int i = 1; i < savedCount; i++) {
+                if (saved[i].lastUsed < saved[idx].lastUsed) idx = i;
+            }
         }
+        memset(&saved[idx], 0, sizeof(SavedNetwork));
+        strncpy(saved[idx].ssid, ssid, sizeof(saved[idx].ssid) - 1);
     }
 
-    // Add new
-    if (savedCount < MAX_SAVED_NETWORKS) {
-        strncpy(savedSSIDs[savedCount], ssid, sizeof(savedSSIDs[savedCount]) - 1);
-        strncpy(savedPasswords[savedCount], password, sizeof(savedPasswords[savedCount]) - 1);
-        savedCount++;
-        saveSavedNetworks();
-    } else {
-        // Replace oldest (index 0)
-        for (int i = 0; i < MAX_SAVED_NETWORKS - 1; i++) {
-            strcpy(savedSSIDs[i], savedSSIDs[i + 1]);
-            strcpy(savedPasswords[i], savedPasswords[i + 1]);
-        }
-        strncpy(savedSSIDs[MAX_SAVED_NETWORKS - 1], ssid, 32);
-        strncpy(savedPasswords[MAX_SAVED_NETWORKS - 1], password, 64);
-        saveSavedNetworks();
+    // New network, or updated password
+    memset(saved[idx].password, 0, sizeof(saved[idx].password));
+    strncpy(saved[idx].password, password, sizeof(saved[idx].password) - 1);
+
+    // Saved right after a manual connect: remember where we joined
+    if (isConnected() && strcmp(currentSSID, ssid) == 0) {
+        captureFastConnect(idx);
+        recordAttempt(idx, true);
     }
+    saveSavedNetworks();
 }
 
 void WiFiManager::forgetNetwork(int index) {
     if (index < 0 || index >= savedCount) return;
 
     for (int i = index; i < savedCount - 1; i++) {
-        strcpy(savedSSIDs[i], savedSSIDs[i + 1]);
-        strcpy(savedPasswords[i], savedPasswords[i + 1]);
+        saved[i] = saved[i + 1];
     }
     savedCount--;
+    memset(&saved[savedCount], 0, sizeof(SavedNetwork));
     saveSavedNetworks();
 }
 
@@ -234,23 +943,471 @@ int WiFiManager::getSavedCount() {
 
 const char* WiFiManager::getSavedSSID(int index) {
     if (index < 0 || index >= savedCount) return "";
-    return savedSSIDs[index];
+    return saved[index].ssid;
+}
+
+void WiFiManager::setStaticIP(int index, IPAddress ip, IPAddress gateway,
+                              IPAddress subnet, IPAddress dns) {
+    if (index < 0 || index >= savedCount) return;
+
+    FastConnectInfo& fc = saved[index].fast;
+    if (ip == INADDR_NONE) {
+        fc.flags &= ~(FC_STATIC | FC_HAS_LEASE);
+    } else {
+        fc.ip = (uint32_t)ip;
+        fc.gateway = (uint32_t)gateway;
+        fc.subnet = (uint32_t)subnet;
+        fc.dns = (uint32_t)dns;
+        fc.flags = (fc.flags & ~FC_HAS_LEASE) | FC_STATIC;
+    }
+    saveSavedNetworks();
+}
+
+void WiFiManager::parseHost(const char* url, char* host, size_t len) {
+    // "https://api.example.com:443/path" -> "api.example.com"
+    const char* start = strstr(url, "://");
+    start = start ? start + 3 : url;
+
+    size_t n = 0;
+    while (start[n] && start[n] != '/' && start[n] != ':' && start[n] != '?' && n < len - 1) {
+        host[n] = start[n];
+        n++;
+    }
+    host[n] = '\0';
+}
+
+uint16_t WiFiManager::parsePort(const char* url, bool* secure) {
+    *secure = strncmp(url, "https://", 8) == 0;
+
+    const char* start = strstr(url, "://");
+    start = start ? start + 3 : url;
+    while (*start && *start != '/' && *start != ':' && *start != '?') start++;
+    if (*start == ':') return (uint16_t)atoi(start + 1);
+    return *secure ? 443 : 80;
+}
+
+HostHealth* WiFiManager::findHost(const char* host, bool create) {
+    for (int i = 0; i < hostCount; i++) {
+        if (strcmp(hosts[i].host, host) == 0) return &hosts[i];
+    }
+    if (!create) return nullptr;
+
+    // Take a free slot, or recycle the least recently used one
+    int slot = hostCount;
+    if (hostCount < MAX_TRACKED_HOSTS) {
+        hostCount++;
+    } else {
+        slot = 0;
+        for (int i = 1; i < MAX_TRACKED_HOSTS; i++) {
+            if (hosts[i].lastUsed < hosts[slot].lastUsed) slot = i;
+        }
+    }
+
+    HostHealth* h = &hosts[slot];
+    memset(h, 0, sizeof(HostHealth));
+    strncpy(h->host, host, sizeof(h->host) - 1);
+    h->state = HostState::CLOSED;
+    return h;
+}
+
+bool WiFiManager::allowRequest(HostHealth* h) {
+    if (h->state != HostState::OPEN) return true;
+
+    if ((long)(millis() - h->retryAt) < 0) return false;
+
+    // Backoff elapsed: let one probe through
+    h->state = HostState::HALF_OPEN;
+    return true;
+}
+
+void WiFiManager::recordResult(HostHealth* h, int httpCode) {
+    // Out of heap here says nothing about the host
+    if (httpCode == HTTP_ERROR_NO_MEMORY) return;
+
+    // Only transport errors and server-side trouble count against the host;
+    // a 404 or 401 means the host itself is up
+    bool failed = httpCode <= 0 || httpCode >= 500 || httpCode == 429;
+
+    if (!failed) {
+        h->state = HostState::CLOSED;
+        h->consecutiveFailures = 0;
+        return;
+    }
+
+    h->failures++;
+    totalFailures++;
+    if (h->consecutiveFailures < 255) h->consecutiveFailures++;
+
+    // Exponential backoff with +/-25% jitter so several devices (or
+    // several apps) don't retry in lockstep
+    int shift = min((int)h->consecutiveFailures - 1, 8);
+    unsigned long delayMs = min((unsigned long)HOST_BACKOFF_BASE_MS << shift,
+                                (unsigned long)HOST_BACKOFF_MAX_MS);
+    delayMs = delayMs * 3 / 4 + random(delayMs / 2 + 1);
+
+    h->state = HostState::OPEN;
+    h->retryAt = millis() + delayMs;
+
+    Serial.printf("HTTP %s failed (%d), retry in %lums\n", h->host, httpCode, delayMs);
+}
+
+unsigned long WiFiManager::getRetryDelay(const char* url) {
+    char host[48];
+    parseHost(url, host, sizeof(host));
+
+    HostHealth* h = findHost(host, false);
+    if (!h || h->state != HostState::OPEN) return 0;
+
+    long remaining = (long)(h->retryAt - millis());
+    return remaining > 0 ? (unsigned long)remaining : 0;
+}
+
+int WiFiManager::getHostCount() {
+    return hostCount;
+}
+
+const HostHealth* WiFiManager::getHostHealth(int index) {
+    if (index < 0 || index >= hostCount) return nullptr;
+    return &hosts[index];
+}
+
+uint32_t WiFiManager::getTotalFailures() {
+    return totalFailures;
+}
+
+uint32_t WiFiManager::getConnectCount() {
+    return connectCount;
+}
+
+uint32_t WiFiManager::getDropCount() {
+    return dropCount;
+}
+
+void WiFiManager::onConnected() {
+    connectCount++;
+
+    // Answers from another network may point somewhere else (split DNS,
+    // captive portals); only keep them across reconnects to the same one
+    if (strcmp(dnsNetwork, currentSSID) != 0) {
+        flushDnsCache();
+        strncpy(dnsNetwork, currentSSID, sizeof(dnsNetwork) - 1);
+    }
+    prefetchIndex = 0;
+    prefetchPending = false;
+}
+
+DnsEntry* WiFiManager::findDns(const char* host) {
+    for (int i = 0; i < dnsCount; i++) {
+        if (strcmp(dnsCache[i].host, host) == 0) return &dnsCache[i];
+    }
+    return nullptr;
+}
+
+void WiFiManager::storeDns(const char* host, uint32_t ip) {
+    DnsEntry* e = findDns(host);
+    if (!e) {
+        // Take a free slot, or recycle the least recently used one
+        if (dnsCount < DNS_CACHE_SIZE) {
+            e = &dnsCache[dnsCount++];
+        } else {
+            e = &dnsCache[0];
+            for (int i = 1; i < DNS_CACHE_SIZE; i++) {
+                if (dnsCache[i].lastUsed < e->lastUsed) e = &dnsCache[i];
+            }
+        }
+        memset(e, 0, sizeof(DnsEntry));
+        strncpy(e->host, host, sizeof(e->host) - 1);
+    }
+    e->ip = ip;
+    e->resolvedAt = millis();
+    e->lastUsed = e->resolvedAt;
+}
+
+void WiFiManager::evictDns(const char* host) {
+    DnsEntry* e = findDns(host);
+    if (!e) return;
+    *e = dnsCache[--dnsCount];
+}
+
+void WiFiManager::flushDnsCache() {
+    dnsCount = 0;
+}
+
+const DnsStats& WiFiManager::getDnsStats() {
+    return dnsStats;
+}
+
+bool WiFiManager::resolveHost(const char* host, IPAddress& ip) {
+    unsigned long now = millis();
+    DnsEntry* e = findDns(host);
+    if (e && now - e->resolvedAt < DNS_CACHE_TTL_MS) {
+        dnsStats.hits++;
+        e->lastUsed = now;
+        ip = IPAddress(e->ip);
+        return true;
+    }
+
+    if (WiFi.hostByName(host, ip) == 1 && (uint32_t)ip != 0) {
+        dnsStats.misses++;
+        storeDns(host, (uint32_t)ip);
+        return true;
+    }
+
+    dnsStats.failures++;
+    if (e) {
+        // Resolver trouble: an old answer beats no answer
+        dnsStats.staleServed++;
+        e->lastUsed = now;
+        ip = IPAddress(e->ip);
+        return true;
+    }
+    return false;
+}
+
+void WiFiManager::dnsFoundCallback(const char* name, const ip_addr_t* ipaddr, void* arg) {
+    // Runs on the lwIP thread; a late answer to an abandoned lookup is dropped
+    if ((uint32_t)(uintptr_t)arg != prefetchGen) return;
+    prefetchIp = ipaddr ? ipaddr->u_addr.ip4.addr : 0;
+    prefetchDone = true;
+}
+
+void WiFiManager::updatePrefetch() {
+    if (prefetchIndex < 0) return;
+
+    // One lookup in flight at a time, without blocking the loop
+    if (prefetchPending) {
+        if (!prefetchDone && millis() - prefetchStart < DNS_PREFETCH_TIMEOUT_MS) return;
+        if (prefetchDone && prefetchIp) {
+            storeDns(PREFETCH_HOSTS[prefetchIndex], prefetchIp);
+            dnsStats.prefetched++;
+        }
+        prefetchPending = false;
+        prefetchIndex++;
+    }
+
+    if (prefetchIndex >= PREFETCH_HOST_COUNT) {
+        Serial.printf("DNS: prefetch done, %d cached\n", dnsCount);
+        prefetchIndex = -1;
+        return;
+    }
+
+    const char* host = PREFETCH_HOSTS[prefetchIndex];
+    DnsEntry* e = findDns(host);
+    if (e && millis() - e->resolvedAt < DNS_CACHE_TTL_MS) {
+        prefetchIndex++;
+        return;
+    }
+
+    ip_addr_t addr;
+    prefetchDone = false;
+    prefetchIp = 0;
+    uint32_t generation = ++prefetchGen;
+    err_t err = dns_gethostbyname(host, &addr, dnsFoundCallback, (void*)(uintptr_t)generation);
+    if (err == ERR_OK) {
+        // Already in lwIP's own (small) table
+        storeDns(host, addr.u_addr.ip4.addr);
+        dnsStats.prefetched++;
+        prefetchIndex++;
+    } else if (err == ERR_INPROGRESS) {
+        prefetchPending = true;
+        prefetchStart = millis();
+    } else {
+        prefetchIndex++;
+    }
 }
 
 String WiFiManager::httpGet(const char* url) {
-    if (!isConnected()) return "";
+    if (!canFetch()) return "";
 
-    HTTPClient http;
-    http.begin(url);
-    http.setTimeout(10000);
+    char hostName[48];
+    parseHost(url, hostName, sizeof(hostName));
+    HostHealth* h = findHost(hostName, true);
+    h->lastUsed = millis();
+
+    // Fail fast while the breaker is open
+    if (!allowRequest(h)) {
+        h->rejected++;
+        return "";
+    }
+    h->requests++;
+
+    RequestRecord rec;
+    memset(&rec, 0, sizeof(rec));
+    strncpy(rec.host, hostName, sizeof(rec.host) - 1);
+    rec.retries = h->consecutiveFailures;
+
+    // Replay goes through the same breaker and telemetry as live traffic,
+    // so injected failures exercise the backoff paths too
+    const char* target = url;
+    char rewritten[256];
+    if (HttpFixtures::isReplaying()) {
+        unsigned long t0 = millis();
+        String body;
+        int code;
+        if (HttpFixtures::replay(url, body, code)) {
+            rec.at = t0;
+            rec.ttfbMs = millis() - t0;
+            rec.status = code;
+            rec.bytes = body.length();
+            rec.wireBytes = rec.bytes;
+            logRequest(rec, h);
+            recordResult(h, code);
+            return code == HTTP_CODE_OK ? body : String("");
+        }
+        if (HttpFixtures::rewriteUrl(url, rewritten, sizeof(rewritten))) target = rewritten;
+    }
+
+    // Host and port of the server actually contacted (the stand-in, if any)
+    char connectHost[48];
+    parseHost(target, connectHost, sizeof(connectHost));
+    bool secure;
+    uint16_t port = parsePort(target, &secure);
 
-    int httpCode = http.GET();
+    // Resolve and connect ourselves so each phase can be timed; HTTPClient
+    // then reuses the open connection. setInsecure() matches what
+    // HTTPClient::begin(url) did for https without a CA.
+    unsigned long t0 = millis();
+    rec.at = t0;
+    IPAddress ip;
+    bool resolved = resolveHost(connectHost, ip);
+    unsigned long t1 = millis();
+    rec.dnsMs = t1 - t0;
+
+    WiFiClient* client;
+    bool connected = false;
+    if (secure) {
+        WiFiClientSecure* tls = new WiFiClientSecure();
+        tls->setInsecure();
+        tls->setHandshakeTimeout(10);
+        if (resolved) connected = tls->connect(ip, port, connectHost, nullptr, nullptr, nullptr);
+        client = tls;
+    } else {
+        client = new WiFiClient();
+        if (resolved) connected = client->connect(ip, port);
+    }
+    unsigned long t2 = millis();
+    rec.connectMs = t2 - t1;
+
+    // The cached address may have moved; look it up again next time
+    if (resolved && !connected) evictDns(connectHost);
+
+    int httpCode = HTTPC_ERROR_CONNECTION_REFUSED;
     String payload = "";
 
-    if (httpCode == HTTP_CODE_OK) {
-        payload = http.getString();
+    if (connected) {
+        // Ask for compression only while the inflater's 32 KB window fits
+        bool compressed = HTTP_ACCEPT_COMPRESSED && HttpInflate::hasMemory();
+
+        HTTPClient http;
+        http.setReuse(false);
+        if (compressed) {
+            // HTTP/1.0 also drops HTTPClient's own identity-only Accept-Encoding
+            http.useHTTP10(true);
+        }
+        http.begin(*client, target);
+        http.setTimeout(10000);
+        if (compressed) {
+            http.addHeader("Accept-Encoding", "gzip, deflate");
+        }
+        const char* headerKeys[] = {"Content-Encoding"};
+        http.collectHeaders(headerKeys, 1);
+
+        httpCode = http.GET();
+        unsigned long t3 = millis();
+        rec.ttfbMs = t3 - t2;
+
+        if (httpCode == HTTP_CODE_OK) {
+            HttpInflate::Format encoding = HttpInflate::parseEncoding(http.header("Content-Encoding"));
+            if (encoding == HttpInflate::Format::NONE) {
+                payload = http.getString();
+                rec.wireBytes = payload.length();
+            } else {
+                HttpInflate::Result result =
+                    HttpInflate::decode(*client, http.getSize(), encoding, payload, rec.wireBytes);
+                if (result != HttpInflate::Result::OK) {
+                    Serial.printf("HTTP %s: compressed body failed to decode\n", hostName);
+                    payload = "";
+                    httpCode = result == HttpInflate::Result::NO_MEMORY ?
+                               HTTP_ERROR_NO_MEMORY : HTTP_ERROR_DECODE;
+                }
+            }
+        }
+        rec.bodyMs = millis() - t3;
+        http.end();
     }
+    client->stop();
+    delete client;
 
-    http.end();
+    rec.status = httpCode;
+    rec.bytes = payload.length();
+    logRequest(rec, h);
+    recordResult(h, httpCode);
+
+    if (HttpFixtures::isRecording()) {
+        HttpFixtures::record(url, httpCode, payload);
+    }
     return payload;
 }
+
+void WiFiManager::logRequest(const RequestRecord& rec, HostHealth* h) {
+    requestLog[requestLogHead] = rec;
+    requestLogHead = (requestLogHead + 1) % NET_LOG_SIZE;
+    if (requestLogCount < NET_LOG_SIZE) requestLogCount++;
+
+    uint32_t total = rec.dnsMs + rec.connectMs + rec.ttfbMs + rec.bodyMs;
+    h->bytes += rec.bytes;
+    h->wireBytes += rec.wireBytes;
+    h->dnsMs += rec.dnsMs;
+    h->connectMs += rec.connectMs;
+    h->ttfbMs += rec.ttfbMs;
+    h->bodyMs += rec.bodyMs;
+    if (total > h->maxTotalMs) h->maxTotalMs = total;
+    totalRequestBytes += rec.bytes;
+    totalWireBytes += rec.wireBytes;
+}
+
+int WiFiManager::getRequestLogCount() {
+    return requestLogCount;
+}
+
+const RequestRecord* WiFiManager::getRequestLog(int index) {
+    if (index < 0 || index >= requestLogCount) return nullptr;
+    int slot = (requestLogHead - 1 - index + NET_LOG_SIZE) % NET_LOG_SIZE;
+    return &requestLog[slot];
+}
+
+uint32_t WiFiManager::getTotalRequestBytes() {
+    return totalRequestBytes;
+}
+
+uint32_t WiFiManager::getTotalWireBytes() {
+    return totalWireBytes;
+}
+
+void WiFiManager::dumpTelemetryCsv(Print& out) {
+    // Oldest first, so the output reads as a timeline
+    out.println("at_ms,host,status,retries,dns_ms,connect_ms,ttfb_ms,body_ms,bytes,wire_bytes");
+    for (int i = requestLogCount - 1; i >= 0; i--) {
+        const RequestRecord* r = getRequestLog(i);
+        out.printf("%lu,%s,%d,%u,%u,%u,%u,%u,%lu,%lu\n",
+                   (unsigned long)r->at, r->host, r->status, r->retries,
+                   r->dnsMs, r->connectMs, r->ttfbMs, r->bodyMs, (unsigned long)r->bytes,
+                   (unsigned long)r->wireBytes);
+    }
+
+    out.println("host,requests,failures,rejected,bytes,wire_bytes,avg_dns_ms,avg_connect_ms,avg_ttfb_ms,avg_body_ms,max_total_ms");
+    for (int i = 0; i < hostCount; i++) {
+        const HostHealth& h = hosts[i];
+        uint32_t n = h.requests ? h.requests : 1;
+        out.printf("%s,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu\n", h.host,
+                   (unsigned long)h.requests, (unsigned long)h.failures, (unsigned long)h.rejected,
+                   (unsigned long)h.bytes, (unsigned long)h.wireBytes, (unsigned long)(h.dnsMs / n),
+                   (unsigned long)(h.connectMs / n), (unsigned long)(h.ttfbMs / n),
+                   (unsigned long)(h.bodyMs / n), (unsigned long)h.maxTotalMs);
+    }
+
+    out.println("dns_hits,dns_misses,dns_failures,dns_stale,dns_prefetched");
+    out.printf("%lu,%lu,%lu,%lu,%lu\n", (unsigned long)dnsStats.hits,
+               (unsigned long)dnsStats.misses, (unsigned long)dnsStats.failures,
+               (unsigned long)dnsStats.staleServed, (unsigned long)dnsStats.prefetched);
+}
@@ -0,0 +1,232 @@
+// HttpInflate against known gzip and zlib bodies, fed through a fake
+// client in reads of different sizes. Runs on the device (pio test -e
+// esp32dev), where the ROM inflater lives.
+#include <Arduino.h>
+#include <unity.h>
+#include "http_inflate.h"
+
+// The bodies are LINE for ids 0..n-1 (n = 1 for SHORT, 200 for LONG),
+// from python3 gzip.compress(text, 9, mtime=0) and zlib.compress(text, 9)
+static const char* LINE =
+    "{\"id\":%d,\"title\":\"Gzip test line\",\"body\":\"The quick brown fox jumps over the lazy dog\"},";
+
+static const uint8_t GZIP_SHORT[] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x0d, 0xc9,
+    0x4b, 0x16, 0x40, 0x30, 0x0c, 0x05, 0xd0, 0xad, 0xbc, 0x93, 0x71, 0x07,
+    0xc6, 0x36, 0x60, 0x03, 0x36, 0x80, 0x06, 0xa1, 0x9a, 0x22, 0xfe, 0xc7,
+    0xde, 0x99, 0xde, 0xfb, 0x90, 0x78, 0xca, 0x33, 0x47, 0x26, 0x16, 0x98,
+    0x72, 0x2a, 0x6e, 0x49, 0x30, 0x5e, 0x0d, 0x41, 0x22, 0x93, 0xa3, 0x5a,
+    0xfd, 0xf5, 0x7b, 0xd9, 0x33, 0xe6, 0x4d, 0x9a, 0x11, 0xf5, 0xa2, 0x47,
+    0x44, 0xab, 0x27, 0x86, 0x6d, 0x4a, 0x2b, 0x74, 0xe7, 0x05, 0xf6, 0x77,
+    0xa8, 0xee, 0x0b, 0x5e, 0x3b, 0x7a, 0xdd, 0x07, 0xf4, 0x77, 0x94, 0xf5,
+    0x57, 0x00, 0x00, 0x00,
+};
+
+static const uint8_t GZIP_LONG[] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xb5, 0xdb,
+    0x51, 0x52, 0x13, 0x41, 0x18, 0x85, 0xd1, 0xad, 0x4c, 0xcd, 0x73, 0x1e,
+    0xe6, 0x76, 0xf7, 0xf4, 0xcc, 0xb0, 0x01, 0x37, 0xe0, 0x06, 0xc4, 0x44,
+    0x8d, 0x46, 0x82, 0x30, 0xa8, 0x40, 0xb9, 0x77, 0x29, 0xd7, 0xe0, 0x79,
+    0x85, 0xaa, 0xff, 0xed, 0x54, 0x20, 0xf7, 0xeb, 0xd7, 0xf1, 0x7c, 0x1c,
+    0x6f, 0xa6, 0xc3, 0xb8, 0x9f, 0xf7, 0xcb, 0x69, 0xbc, 0x19, 0xdf, 0xbd,
+    0x9c, 0xef, 0x87, 0xfd, 0xf4, 0xb8, 0x0f, 0x97, 0xf3, 0xdd, 0x69, 0x3c,
+    0x8c, 0xb7, 0xd7, 0xe3, 0xf3, 0xdb, 0xcf, 0xdf, 0x7f, 0x39, 0x0d, 0x3f,
+    0x9e, 0xce, 0x1f, 0xbf, 0x0d, 0xb7, 0x0f, 0xd7, 0x5f, 0x77, 0xc3, 0xa7,
+    0xeb, 0xef, 0xe1, 0xeb, 0xd3, 0xf7, 0xfb, 0xc7, 0xe1, 0xfa, 0xf3, 0xf4,
+    0x30, 0xec, 0x6f, 0xbf, 0xbe, 0x7c, 0x78, 0x79, 0x1e, 0x8e, 0xd7, 0xcf,
+    0xe3, 0x9f, 0xc3, 0xeb, 0xbf, 0xb3, 0x31, 0x67, 0x8b, 0x39, 0x5b, 0xcd,
+    0xd9, 0x66, 0xce, 0xce, 0xe6, 0x6c, 0x37, 0x67, 0x17, 0x73, 0x76, 0x35,
+    0x67, 0x37, 0xc4, 0x41, 0x31, 0x43, 0xce, 0x82, 0xa0, 0x05, 0x49, 0x0b,
+    0xa2, 0x16, 0x64, 0x2d, 0x08, 0x5b, 0x90, 0xb6, 0x20, 0x6e, 0x41, 0xde,
+    0x0a, 0xf2, 0x56, 0xd4, 0xe7, 0x1a, 0xf2, 0x56, 0x90, 0xb7, 0x82, 0xbc,
+    0x15, 0xe4, 0xad, 0x20, 0x6f, 0x05, 0x79, 0x2b, 0xc8, 0x5b, 0x41, 0xde,
+    0x2a, 0xf2, 0x56, 0x91, 0xb7, 0xaa, 0xfe, 0x90, 0x44, 0xde, 0x2a, 0xf2,
+    0x56, 0x91, 0xb7, 0x8a, 0xbc, 0x55, 0xe4, 0xad, 0x22, 0x6f, 0x15, 0x79,
+    0x6b, 0xc8, 0x5b, 0x43, 0xde, 0x1a, 0xf2, 0xd6, 0xd4, 0x7f, 0x6e, 0xc8,
+    0x5b, 0x43, 0xde, 0x1a, 0xf2, 0xd6, 0x90, 0xb7, 0x86, 0xbc, 0x35, 0xe4,
+    0x6d, 0x46, 0xde, 0x66, 0xe4, 0x6d, 0x46, 0xde, 0x66, 0xe4, 0x6d, 0x56,
+    0x5f, 0x95, 0x20, 0x6f, 0x33, 0xf2, 0x36, 0x23, 0x6f, 0x33, 0xf2, 0x36,
+    0x23, 0x6f, 0x1d, 0x79, 0xeb, 0xc8, 0x5b, 0x47, 0xde, 0x3a, 0xf2, 0xd6,
+    0x91, 0xb7, 0xae, 0xbe, 0x9b, 0x44, 0xde, 0x3a, 0xf2, 0xd6, 0x91, 0xb7,
+    0x8e, 0xbc, 0x2d, 0xc8, 0xdb, 0x82, 0xbc, 0x2d, 0xc8, 0xdb, 0x82, 0xbc,
+    0x2d, 0xc8, 0xdb, 0x82, 0xbc, 0x2d, 0x6a, 0x0c, 0x40, 0xde, 0x16, 0xe4,
+    0x6d, 0x41, 0xde, 0x56, 0xe4, 0x6d, 0x45, 0xde, 0x56, 0xe4, 0x6d, 0x45,
+    0xde, 0x56, 0xe4, 0x6d, 0x45, 0xde, 0x56, 0xe4, 0x6d, 0x55, 0xeb, 0x1b,
+    0xf2, 0xb6, 0x22, 0x6f, 0x1b, 0xf2, 0xb6, 0x21, 0x6f, 0x1b, 0xf2, 0xb6,
+    0x21, 0x6f, 0x1b, 0xf2, 0xb6, 0x21, 0x6f, 0x1b, 0xf2, 0xb6, 0x21, 0x6f,
+    0x9b, 0x9a, 0xbb, 0xd9, 0xde, 0xad, 0x06, 0xef, 0x49, 0x2d, 0xde, 0x93,
+    0x9a, 0xbc, 0x27, 0xb5, 0x79, 0x4f, 0x6a, 0xf4, 0x9e, 0xd4, 0xea, 0x3d,
+    0xa9, 0xd9, 0x7b, 0x52, 0xbb, 0xf7, 0xa4, 0x86, 0xef, 0x49, 0xc9, 0x73,
+    0xa9, 0x89, 0x92, 0xc7, 0x62, 0x13, 0x56, 0x9b, 0xb0, 0xdc, 0x84, 0xf5,
+    0x26, 0x2c, 0x38, 0x61, 0xc5, 0x09, 0x4b, 0x4e, 0x54, 0x73, 0x12, 0x15,
+    0x9d, 0xa4, 0xb0, 0xca, 0x4b, 0xc9, 0x53, 0xdd, 0x49, 0x54, 0x78, 0x12,
+    0x55, 0x9e, 0x44, 0xa5, 0x27, 0x51, 0xed, 0x49, 0x54, 0x7c, 0x12, 0x55,
+    0x9f, 0x44, 0xe5, 0x27, 0x51, 0xfd, 0x49, 0x2a, 0x0b, 0x2c, 0x95, 0x3c,
+    0x95, 0xa0, 0x44, 0x35, 0x28, 0x51, 0x11, 0x4a, 0x54, 0x85, 0x12, 0x95,
+    0xa1, 0x44, 0x75, 0x28, 0x51, 0x21, 0x4a, 0x54, 0x89, 0x12, 0x95, 0xa2,
+    0xa4, 0xb1, 0xb6, 0x59, 0xc9, 0x53, 0x35, 0x4a, 0x54, 0x8e, 0x12, 0xd5,
+    0xa3, 0x44, 0x05, 0x29, 0x51, 0x45, 0x4a, 0x54, 0x92, 0x12, 0xd5, 0xa4,
+    0x44, 0x45, 0x29, 0x51, 0x55, 0x4a, 0x66, 0xf6, 0xac, 0x40, 0xc9, 0x53,
+    0x61, 0x4a, 0x54, 0x99, 0x12, 0x95, 0xa6, 0x44, 0xb5, 0x29, 0x51, 0x71,
+    0x4a, 0x54, 0x9d, 0x12, 0x95, 0xa7, 0x44, 0xf5, 0x29, 0x51, 0x81, 0x4a,
+    0x3a, 0x7b, 0xd1, 0xa3, 0xe4, 0xa9, 0x46, 0x25, 0x2a, 0x52, 0x89, 0xaa,
+    0x54, 0xa2, 0x32, 0x95, 0xa8, 0x4e, 0x25, 0x2a, 0x54, 0x89, 0x2a, 0x55,
+    0xa2, 0x52, 0x95, 0xa8, 0x56, 0x25, 0x0b, 0x7b, 0x4c, 0xa7, 0xe4, 0xa9,
+    0x5c, 0x25, 0xaa, 0x57, 0x89, 0x0a, 0x56, 0xa2, 0x8a, 0x95, 0xa8, 0x64,
+    0x25, 0xaa, 0x59, 0x89, 0x8a, 0x56, 0xa2, 0xaa, 0x95, 0xa8, 0x6c, 0x25,
+    0x2b, 0x7b, 0xc7, 0xaa, 0xe4, 0xa9, 0x72, 0x25, 0x2a, 0x5d, 0x89, 0x6a,
+    0x57, 0xa2, 0xe2, 0x95, 0xa8, 0x7a, 0x25, 0x2a, 0x5f, 0x89, 0xea, 0x57,
+    0xa2, 0x02, 0x96, 0xa8, 0x82, 0x25, 0x1b, 0x7b, 0x42, 0xfe, 0xdf, 0xe5,
+    0xfd, 0x05, 0x19, 0xca, 0xa9, 0xaf, 0x1a, 0x45, 0x00, 0x00,
+};
+
+static const uint8_t ZLIB_LONG[] = {
+    0x78, 0xda, 0xb5, 0xdb, 0x51, 0x52, 0x13, 0x41, 0x18, 0x85, 0xd1, 0xad,
+    0x4c, 0xcd, 0x73, 0x1e, 0xe6, 0x76, 0xf7, 0xf4, 0xcc, 0xb0, 0x01, 0x37,
+    0xe0, 0x06, 0xc4, 0x44, 0x8d, 0x46, 0x82, 0x30, 0xa8, 0x40, 0xb9, 0x77,
+    0x29, 0xd7, 0xe0, 0x79, 0x85, 0xaa, 0xff, 0xed, 0x54, 0x20, 0xf7, 0xeb,
+    0xd7, 0xf1, 0x7c, 0x1c, 0x6f, 0xa6, 0xc3, 0xb8, 0x9f, 0xf7, 0xcb, 0x69,
+    0xbc, 0x19, 0xdf, 0xbd, 0x9c, 0xef, 0x87, 0xfd, 0xf4, 0xb8, 0x0f, 0x97,
+    0xf3, 0xdd, 0x69, 0x3c, 0x8c, 0xb7, 0xd7, 0xe3, 0xf3, 0xdb, 0xcf, 0xdf,
+    0x7f, 0x39, 0x0d, 0x3f, 0x9e, 0xce, 0x1f, 0xbf, 0x0d, 0xb7, 0x0f, 0xd7,
+    0x5f, 0x77, 0xc3, 0xa7, 0xeb, 0xef, 0xe1, 0xeb, 0xd3, 0xf7, 0xfb, 0xc7,
+    0xe1, 0xfa, 0xf3, 0xf4, 0x30, 0xec, 0x6f, 0xbf, 0xbe, 0x7c, 0x78, 0x79,
+    0x1e, 0x8e, 0xd7, 0xcf, 0xe3, 0x9f, 0xc3, 0xeb, 0xbf, 0xb3, 0x31, 0x67,
+    0x8b, 0x39, 0x5b, 0xcd, 0xd9, 0x66, 0xce, 0xce, 0xe6, 0x6c, 0x37, 0x67,
+    0x17, 0x73, 0x76, 0x35, 0x67, 0x37, 0xc4, 0x41, 0x31, 0x43, 0xce, 0x82,
+    0xa0, 0x05, 0x49, 0x0b, 0xa2, 0x16, 0x64, 0x2d, 0x08, 0x5b, 0x90, 0xb6,
+    0x20, 0x6e, 0x41, 0xde, 0x0a, 0xf2, 0x56, 0xd4, 0xe7, 0x1a, 0xf2, 0x56,
+    0x90, 0xb7, 0x82, 0xbc, 0x15, 0xe4, 0xad, 0x20, 0x6f, 0x05, 0x79, 0x2b,
+    0xc8, 0x5b, 0x41, 0xde, 0x2a, 0xf2, 0x56, 0x91, 0xb7, 0xaa, 0xfe, 0x90,
+    0x44, 0xde, 0x2a, 0xf2, 0x56, 0x91, 0xb7, 0x8a, 0xbc, 0x55, 0xe4, 0xad,
+    0x22, 0x6f, 0x15, 0x79, 0x6b, 0xc8, 0x5b, 0x43, 0xde, 0x1a, 0xf2, 0xd6,
+    0xd4, 0x7f, 0x6e, 0xc8, 0x5b, 0x43, 0xde, 0x1a, 0xf2, 0xd6, 0x90, 0xb7,
+    0x86, 0xbc, 0x35, 0xe4, 0x6d, 0x46, 0xde, 0x66, 0xe4, 0x6d, 0x46, 0xde,
+    0x66, 0xe4, 0x6d, 0x56, 0x5f, 0x95, 0x20, 0x6f, 0x33, 0xf2, 0x36, 0x23,
+    0x6f, 0x33, 0xf2, 0x36, 0x23, 0x6f, 0x1d, 0x79, 0xeb, 0xc8, 0x5b, 0x47,
+    0xde, 0x3a, 0xf2, 0xd6, 0x91, 0xb7, 0xae, 0xbe, 0x9b, 0x44, 0xde, 0x3a,
+    0xf2, 0xd6, 0x91, 0xb7, 0x8e, 0xbc, 0x2d, 0xc8, 0xdb, 0x82, 0xbc, 0x2d,
+    0xc8, 0xdb, 0x82, 0xbc, 0x2d, 0xc8, 0xdb, 0x82, 0xbc, 0x2d, 0x6a, 0x0c,
+    0x40, 0xde, 0x16, 0xe4, 0x6d, 0x41, 0xde, 0x56, 0xe4, 0x6d, 0x45, 0xde,
+    0x56, 0xe4, 0x6d, 0x45, 0xde, 0x56, 0xe4, 0x6d, 0x45, 0xde, 0x56, 0xe4,
+    0x6d, 0x55, 0xeb, 0x1b, 0xf2, 0xb6, 0x22, 0x6f, 0x1b, 0xf2, 0xb6, 0x21,
+    0x6f, 0x1b, 0xf2, 0xb6, 0x21, 0x6f, 0x1b, 0xf2, 0xb6, 0x21, 0x6f, 0x1b,
+    0xf2, 0xb6, 0x21, 0x6f, 0x9b, 0x9a, 0xbb, 0xd9, 0xde, 0xad, 0x06, 0xef,
+    0x49, 0x2d, 0xde, 0x93, 0x9a, 0xbc, 0x27, 0xb5, 0x79, 0x4f, 0x6a, 0xf4,
+    0x9e, 0xd4, 0xea, 0x3d, 0xa9, 0xd9, 0x7b, 0x52, 0xbb, 0xf7, 0xa4, 0x86,
+    0xef, 0x49, 0xc9, 0x73, 0xa9, 0x89, 0x92, 0xc7, 0x62, 0x13, 0x56, 0x9b,
+    0xb0, 0xdc, 0x84, 0xf5, 0x26, 0x2c, 0x38, 0x61, 0xc5, 0x09, 0x4b, 0x4e,
+    0x54, 0x73, 0x12, 0x15, 0x9d, 0xa4, 0xb0, 0xca, 0x4b, 0xc9, 0x53, 0xdd,
+    0x49, 0x54, 0x78, 0x12, 0x55, 0x9e, 0x44, 0xa5, 0x27, 0x51, 0xed, 0x49,
+    0x54, 0x7c, 0x12, 0x55, 0x9f, 0x44, 0xe5, 0x27, 0x51, 0xfd, 0x49, 0x2a,
+    0x0b, 0x2c, 0x95, 0x3c, 0x95, 0xa0, 0x44, 0x35, 0x28, 0x51, 0x11, 0x4a,
+    0x54, 0x85, 0x12, 0x95, 0xa1, 0x44, 0x75, 0x28, 0x51, 0x21, 0x4a, 0x54,
+    0x89, 0x12, 0x95, 0xa2, 0xa4, 0xb1, 0xb6, 0x59, 0xc9, 0x53, 0x35, 0x4a,
+    0x54, 0x8e, 0x12, 0xd5, 0xa3, 0x44, 0x05, 0x29, 0x51, 0x45, 0x4a, 0x54,
+    0x92, 0x12, 0xd5, 0xa4, 0x44, 0x45, 0x29, 0x51, 0x55, 0x4a, 0x66, 0xf6,
+    0xac, 0x40, 0xc9, 0x53, 0x61, 0x4a, 0x54, 0x99, 0x12, 0x95, 0xa6, 0x44,
+    0xb5, 0x29, 0x51, 0x71, 0x4a, 0x54, 0x9d, 0x12, 0x95, 0xa7, 0x44, 0xf5,
+    0x29, 0x51, 0x81, 0x4a, 0x3a, 0x7b, 0xd1, 0xa3, 0xe4, 0xa9, 0x46, 0x25,
+    0x2a, 0x52, 0x89, 0xaa, 0x54, 0xa2, 0x32, 0x95, 0xa8, 0x4e, 0x25, 0x2a,
+    0x54, 0x89, 0x2a, 0x55, 0xa2, 0x52, 0x95, 0xa8, 0x56, 0x25, 0x0b, 0x7b,
+    0x4c, 0xa7, 0xe4, 0xa9, 0x5c, 0x25, 0xaa, 0x57, 0x89, 0x0a, 0x56, 0xa2,
+    0x8a, 0x95, 0xa8, 0x64, 0x25, 0xaa, 0x59, 0x89, 0x8a, 0x56, 0xa2, 0xaa,
+    0x95, 0xa8, 0x6c, 0x25, 0x2b, 0x7b, 0xc7, 0xaa, 0xe4, 0xa9, 0x72, 0x25,
+    0x2a, 0x5d, 0x89, 0x6a, 0x57, 0xa2, 0xe2, 0x95, 0xa8, 0x7a, 0x25, 0x2a,
+    0x5f, 0x89, 0xea, 0x57, 0xa2, 0x02, 0x96, 0xa8, 0x82, 0x25, 0x1b, 0x7b,
+    0x42, 0xfe, 0xdf, 0xe5, 0xfd, 0x05, 0x5d, 0x14, 0x36, 0xd6,
+};
+
+// Serves a body at most `chunk` bytes per read, then closes
+class MemoryClient : public Client {
+public:
+    MemoryClient(const uint8_t* data, size_t len, size_t chunk)
+        : data(data), len(len), chunk(chunk) {}
+
+    int connect(IPAddress, uint16_t) override { return 0; }
+    int connect(const char*, uint16_t) override { return 0; }
+    size_t write(uint8_t) override { return 0; }
+    size_t write(const uint8_t*, size_t) override { return 0; }
+    int available() override { return min(chunk, len - pos); }
+    int read() override { return pos < len ? data[pos++] : -1; }
+    int read(uint8_t* buf, size_t size) override {
+        size_t n = min(size, (size_t)available());
+        memcpy(buf, data + pos, n);
+        pos += n;
+        return n;
+    }
+    int peek() override { return pos < len ? data[pos] : -1; }
+    void flush() override {}
+    void stop() override { pos = len; }
+    uint8_t connected() override { return pos < len; }
+    operator bool() override { return true; }
+
+private:
+    const uint8_t* data;
+    size_t len;
+    size_t chunk;
+    size_t pos = 0;
+};
+
+static const size_t CHUNKS[] = {1, 3, 64, HTTP_INFLATE_IN_CHUNK};
+
+static String expected(int lines) {
+    String s;
+    char buf[128];
+    for (int i = 0; i < lines; i++) {
+        snprintf(buf, sizeof(buf), LINE, i);
+        s += buf;
+    }
+    return s;
+}
+
+static void checkDecode(const uint8_t* body, size_t len, HttpInflate::Format format, int lines) {
+    String want = expected(lines);
+    for (size_t chunk : CHUNKS) {
+        // With a Content-Length, and read until the server closes
+        for (int contentLength : {(int)len, -1}) {
+            MemoryClient client(body, len, chunk);
+            String out;
+            uint32_t wire = 0;
+            HttpInflate::Result result = HttpInflate::decode(client, contentLength, format, out, wire);
+            TEST_ASSERT_EQUAL_MESSAGE((int)HttpInflate::Result::OK, (int)result, "decode failed");
+            TEST_ASSERT_EQUAL_UINT32(len, wire);
+            TEST_ASSERT_EQUAL_STRING(want.c_str(), out.c_str());
+        }
+    }
+}
+
+static void test_gzip_short() {
+    checkDecode(GZIP_SHORT, sizeof(GZIP_SHORT), HttpInflate::Format::GZIP, 1);
+}
+
+static void test_gzip_long() {
+    checkDecode(GZIP_LONG, sizeof(GZIP_LONG), HttpInflate::Format::GZIP, 200);
+}
+
+static void test_zlib_long() {
+    checkDecode(ZLIB_LONG, sizeof(ZLIB_LONG), HttpInflate::Format::ZLIB, 200);
+}
+
+static void test_gzip_bad_trailer() {
+    static uint8_t body[sizeof(GZIP_LONG)];
+    memcpy(body, GZIP_LONG, sizeof(body));
+    body[sizeof(body) - 8] ^= 0x01;     // CRC-32
+    MemoryClient client(body, sizeof(body), 64);
+    String out;
+    uint32_t wire = 0;
+    TEST_ASSERT_EQUAL((int)HttpInflate::Result::FAILED,
+                      (int)HttpInflate::decode(client, sizeof(body), HttpInflate::Format::GZIP, out, wire));
+}
+
+void setup() {
+    delay(2000);    // Let the serial monitor attach
+    UNITY_BEGIN();
+    RUN_TEST(test_gzip_short);
+    RUN_TEST(test_gzip_long);
+    RUN_TEST(test_zlib_long);
+    RUN_TEST(test_gzip_bad_trailer);
+    UNITY_END();
+}
+
+void loop() {}
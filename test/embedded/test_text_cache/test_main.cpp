@@ -0,0 +1,157 @@
+// TextCache against drawing directly: a cached blit must leave the frame
+// buffer exactly as u8g2.drawStr does, in both font modes and colours,
+// and the keyboard and title-bar frames are timed with the cache off and
+// on. Runs on the device (pio test -e esp32dev), on the real U8g2; frames
+// go nowhere, so the timings are drawing only, not the I2C transfer.
+#include <Arduino.h>
+#include <unity.h>
+#include "ui.h"
+#include "keyboard.h"
+#include "text_cache.h"
+
+static const int FRAME_BYTES = SCREEN_WIDTH * SCREEN_HEIGHT / 8;
+static const int BENCH_FRAMES = 200;
+
+static const char* const STRINGS[] = {
+    "Weather", "A:Fetch C:City", "B:Back", "A:sel B:back C:mode D:exit", "x",
+};
+
+// Baselines near the top, across a page boundary, at the bottom; x near
+// the right edge clips
+static const int POSITIONS[][2] = {{0, 8}, {3, 13}, {2, 30}, {100, 63}};
+
+static uint8_t direct[FRAME_BYTES];
+
+// 0 cleared, 1 set, 2 mixed, so both kinds of pixel sit under every glyph
+static void fillBackground(int kind) {
+    uint8_t* buf = u8g2.getBufferPtr();
+    for (int i = 0; i < FRAME_BYTES; i++) {
+        buf[i] = kind == 0 ? 0x00 : kind == 1 ? 0xFF : (uint8_t)(0x5A ^ (i * 37));
+    }
+}
+
+static void checkDrawStr(const char* text, int x, int y) {
+    uint8_t* buf = u8g2.getBufferPtr();
+    for (int bg = 0; bg < 3; bg++) {
+        TextCache::setEnabled(false);
+        fillBackground(bg);
+        u8g2.drawStr(x, y, text);
+        memcpy(direct, buf, FRAME_BYTES);
+
+        // The first call draws directly and fills the cache, the second blits
+        TextCache::setEnabled(true);
+        for (int pass = 0; pass < 2; pass++) {
+            fillBackground(bg);
+            TextCache::drawStr(x, y, text);
+        }
+
+        char msg[96];
+        snprintf(msg, sizeof(msg), "\"%s\" at %d,%d, font mode %d, colour %d, background %d",
+                 text, x, y, u8g2.getU8g2()->font_decode.is_transparent,
+                 u8g2.getU8g2()->draw_color, bg);
+        TEST_ASSERT_EQUAL_MEMORY_MESSAGE(direct, buf, FRAME_BYTES, msg);
+    }
+}
+
+static void checkFontMode(uint8_t transparent) {
+    uint32_t hits = TextCache::getHits();
+    u8g2.setFontMode(transparent);
+    for (int font = 0; font < 2; font++) {
+        if (font) {
+            UI::setSmallFont();
+        } else {
+            UI::setNormalFont();
+        }
+        for (uint8_t color = 0; color < 2; color++) {
+            u8g2.setDrawColor(color);
+            for (const char* text : STRINGS) {
+                for (const auto& pos : POSITIONS) checkDrawStr(text, pos[0], pos[1]);
+            }
+        }
+    }
+    u8g2.setDrawColor(1);
+    u8g2.setFontMode(0);
+    TEST_ASSERT_GREATER_THAN_UINT32(hits, TextCache::getHits());
+}
+
+static void test_blit_matches_transparent_mode() {
+    checkFontMode(1);
+}
+
+static void test_blit_matches_solid_mode() {
+    checkFontMode(0);
+}
+
+// The rows are cached layouts, with the cursor drawn over them
+static void test_keyboard_frame_matches() {
+    static char input[32] = "London";
+    Keyboard::show("City:", input, sizeof(input));
+
+    TextCache::setEnabled(false);
+    Keyboard::render();
+    memcpy(direct, u8g2.getBufferPtr(), FRAME_BYTES);
+
+    TextCache::setEnabled(true);
+    Keyboard::render();
+    Keyboard::render();
+    TEST_ASSERT_EQUAL_MEMORY(direct, u8g2.getBufferPtr(), FRAME_BYTES);
+    Keyboard::hide();
+}
+
+static void keyboardFrame() {
+    Keyboard::render();
+}
+
+static void titleBarFrame() {
+    UI::clear();
+    UI::setNormalFont();
+    UI::drawTitleBar("Weather");
+    UI::drawStatusBar("A:Fetch C:City", "B:Back");
+    UI::flush();
+}
+
+// Average us per frame, after one to fill the cache
+static unsigned long frameUs(void (*frame)(), bool cached) {
+    TextCache::setEnabled(cached);
+    frame();
+    unsigned long start = micros();
+    for (int i = 0; i < BENCH_FRAMES; i++) frame();
+    return (micros() - start) / BENCH_FRAMES;
+}
+
+static void test_frame_cost() {
+    static char input[32] = "";
+    char msg[80];
+
+    Keyboard::show("City:", input, sizeof(input));
+    snprintf(msg, sizeof(msg), "keyboard frame: %lu us direct, %lu us cached",
+             frameUs(keyboardFrame, false), frameUs(keyboardFrame, true));
+    TEST_MESSAGE(msg);
+    Keyboard::hide();
+
+    snprintf(msg, sizeof(msg), "title and status bar frame: %lu us direct, %lu us cached",
+             frameUs(titleBarFrame, false), frameUs(titleBarFrame, true));
+    TEST_MESSAGE(msg);
+
+    snprintf(msg, sizeof(msg), "cache: %lu hits, %lu misses, %lu bytes",
+             (unsigned long)TextCache::getHits(), (unsigned long)TextCache::getMisses(),
+             (unsigned long)TextCache::getBytesUsed());
+    TEST_MESSAGE(msg);
+}
+
+void setup() {
+    delay(2000);    // Let the serial monitor attach
+
+    // The display is never started: sendBuffer() goes nowhere
+    u8g2.getU8x8()->byte_cb = u8x8_byte_empty;
+    UI::setNormalFont();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_blit_matches_transparent_mode);
+    RUN_TEST(test_blit_matches_solid_mode);
+    RUN_TEST(test_keyboard_frame_matches);
+    RUN_TEST(test_frame_cost);
+    UNITY_END();
+}
+
+void loop() {}
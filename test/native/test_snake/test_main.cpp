@@ -0,0 +1,76 @@
+// Snake game step and autoplay solver on the host (pio test -e native)
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include "apps/snake_game.h"
+
+static const int SEEDS = 50;
+static const uint32_t MAX_MOVES = 200000;   // A full game takes about 34k
+
+// Plays g with the solver until it dies or fills the board; moves taken
+static uint32_t autoplay(SnakeGame& g) {
+    uint32_t moves = 0;
+    while (g.alive && moves < MAX_MOVES) {
+        g.step(g.planMove());
+        moves++;
+    }
+    return moves;
+}
+
+static void test_autoplay_fills_board() {
+    uint32_t totalMoves = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t seed = 1; seed <= SEEDS; seed++) {
+        static SnakeGame g;
+        g.reset(seed * 2654435761u);
+        totalMoves += autoplay(g);
+
+        char msg[48];
+        snprintf(msg, sizeof(msg), "seed %lu", (unsigned long)seed);
+        TEST_ASSERT_TRUE_MESSAGE(g.boardFull, msg);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(SNAKE_CELLS, g.snakeLen, msg);
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    char report[80];
+    snprintf(report, sizeof(report), "%d boards filled, %lu moves/board, %.0f moves/s",
+             SEEDS, (unsigned long)(totalMoves / SEEDS), totalMoves / secs);
+    TEST_MESSAGE(report);
+}
+
+// Same seed and directions, same game
+static void test_step_is_deterministic() {
+    static SnakeGame a, b;
+    a.reset(12345);
+    b.reset(12345);
+    for (int i = 0; i < 5000 && a.alive; i++) {
+        int dir = a.planMove();
+        TEST_ASSERT_EQUAL(a.step(dir), b.step(dir));
+        TEST_ASSERT_EQUAL(a.foodX, b.foodX);
+        TEST_ASSERT_EQUAL(a.foodY, b.foodY);
+    }
+    TEST_ASSERT_EQUAL(a.snakeLen, b.snakeLen);
+    TEST_ASSERT_EQUAL_MEMORY(a.occupied, b.occupied, sizeof(a.occupied));
+}
+
+static void test_wall_ends_game() {
+    static SnakeGame g;
+    g.reset(1);
+    uint8_t result = 0;
+    for (int i = 0; i < SNAKE_GRID_W && !(result & SnakeGame::STEP_DIED); i++) {
+        result = g.step(0);     // Right, into the wall
+    }
+    TEST_ASSERT_TRUE(result & SnakeGame::STEP_DIED);
+    TEST_ASSERT_FALSE(g.alive);
+    TEST_ASSERT_FALSE(g.boardFull);
+    TEST_ASSERT_EQUAL(0, g.step(0));    // Nothing moves after death
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_step_is_deterministic);
+    RUN_TEST(test_wall_ends_game);
+    RUN_TEST(test_autoplay_fills_board);
+    return UNITY_END();
+}